@@ -0,0 +1,78 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include "benchmark.hpp"
+
+#include "ecs_prefab.hpp"
+
+#include "gravity.hpp"
+#include "rigid_body.hpp"
+#include "transform.hpp"
+
+// PhysicsSystem::update with the archetype chunk storage against the default
+// per-type sparse sets, for bodies created alone (the dense arrays line up)
+// and interleaved with static Transform + RigidBody entities (the sparse-set
+// view walks the Gravity array and reaches the two others out of order).
+
+using namespace engine;
+
+static void add_static_bodies(Coordinator& coordinator, std::size_t count, bool interleaved)
+{
+    component::Gravity gravity;
+    gravity.force = Diligent::float3(0, -9.81f, 0);
+
+    ecs::ECSPrefab body;
+    body.set(component::Transform {})
+        .set(component::RigidBody {})
+        .set(gravity);
+
+    ecs::ECSPrefab static_body;
+    static_body.set(component::Transform {})
+        .set(component::RigidBody {});
+
+    if (!interleaved)
+    {
+        coordinator.instantiate(body, count);
+        return;
+    }
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        coordinator.instantiate(static_body);
+        coordinator.instantiate(body);
+    }
+}
+
+int main()
+{
+    constexpr float DT = 1.0f / 60.0f;
+    constexpr std::size_t RUNS = 21;
+
+    std::cout << std::setw(10) << "bodies" << std::setw(14) << "layout" << std::setw(14) << "sparse ms" << std::setw(14) << "chunks ms" << std::setw(10) << "speedup" << "\n";
+
+    for (std::size_t count : { 5000, 50000, 500000 })
+    {
+        for (bool interleaved : { false, true })
+        {
+            double modes_ms[2];
+
+            for (auto mode : { ecs::ECSStorageMode::SPARSE_SET, ecs::ECSStorageMode::ARCHETYPE })
+            {
+                benchmark::PhysicsScene scene = benchmark::make_physics_scene(0, mode);
+                add_static_bodies(*scene.coordinator, count, interleaved);
+
+                modes_ms[mode == ecs::ECSStorageMode::ARCHETYPE] = benchmark::median_ms(RUNS, [&]() { scene.physics_system->update(DT); });
+            }
+
+            std::cout << std::setw(10) << count
+                      << std::setw(14) << (interleaved ? "interleaved" : "alone")
+                      << std::fixed << std::setprecision(3)
+                      << std::setw(14) << modes_ms[0]
+                      << std::setw(14) << modes_ms[1]
+                      << std::setprecision(1) << std::setw(9) << modes_ms[0] / modes_ms[1] << "x" << std::endl;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "coordinator.hpp"
+
+#include "event.hpp"
+#include "event_types.hpp"
+
+#include "ecs_prefab.hpp"
+
+#include "gravity.hpp"
+#include "rigid_body.hpp"
+#include "transform.hpp"
+
+#include "physics_system.hpp"
+
+namespace benchmark
+{
+    // Runs fn runs times and returns the median duration of a run, in milliseconds
+    template<typename F>
+    double median_ms(std::size_t runs, F&& fn)
+    {
+        std::vector<double> durations(runs);
+
+        for (double& duration : durations)
+        {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            duration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        std::nth_element(durations.begin(), durations.begin() + runs / 2, durations.end());
+
+        return durations[runs / 2];
+    }
+
+    // Thread counts to measure scaling with: the powers of two below the number
+    // of hardware threads, then the number of hardware threads
+    inline std::vector<std::size_t> thread_counts()
+    {
+        std::size_t max_threads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+
+        std::vector<std::size_t> counts;
+        for (std::size_t threads = 1; threads < max_threads; threads *= 2)
+            counts.push_back(threads);
+
+        counts.push_back(max_threads);
+
+        return counts;
+    }
+
+    // A coordinator holding count falling bodies, integrated by a physics system
+    // with gravity switched on
+    struct PhysicsScene
+    {
+        std::unique_ptr<engine::Coordinator> coordinator;
+        std::shared_ptr<engine::system::PhysicsSystem> physics_system;
+    };
+
+    inline PhysicsScene make_physics_scene(
+        std::size_t count,
+        engine::ecs::ECSStorageMode storage_mode = engine::ecs::ECSStorageMode::SPARSE_SET,
+        engine::utils::JobSystem* job_system = nullptr
+    )
+    {
+        using namespace engine;
+
+        PhysicsScene scene;
+        scene.coordinator = std::make_unique<Coordinator>();
+        scene.coordinator->init(storage_mode);
+
+        scene.coordinator->register_component<component::Transform>();
+        scene.coordinator->register_component<component::RigidBody>();
+        scene.coordinator->register_component<component::Gravity>();
+
+        scene.physics_system = scene.coordinator->register_system<system::PhysicsSystem>(*scene.coordinator, job_system);
+        {
+            ecs::ECSMask mask;
+            mask.set(scene.coordinator->get_component_type<component::Transform>());
+            mask.set(scene.coordinator->get_component_type<component::Gravity>());
+            mask.set(scene.coordinator->get_component_type<component::RigidBody>());
+            scene.coordinator->set_system_mask<system::PhysicsSystem>(mask);
+        }
+
+        scene.physics_system->init();
+
+        component::Gravity gravity;
+        gravity.force = Diligent::float3(0, -9.81f, 0);
+
+        ecs::ECSPrefab body;
+        body.set(component::Transform {})
+            .set(component::RigidBody {})
+            .set(gravity);
+
+        scene.coordinator->instantiate(body, count);
+
+        Input input;
+        input.gravity = true;
+
+        event::Event event(event::InputEvent { input });
+        scene.coordinator->send_event(event);
+
+        return scene;
+    }
+}
@@ -0,0 +1,154 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+#include "benchmark.hpp"
+
+#include "gravity.hpp"
+#include "rigid_body.hpp"
+#include "transform.hpp"
+
+// PhysicsSystem::update on the sparse-set component arrays, against the
+// storage they replaced: per-type arrays reached through typeid(T).name()
+// maps, each indexed through an entity -> index hash map, walked from a
+// std::set of entities with three lookups per entity.
+
+namespace baseline
+{
+    using Entity = std::uint32_t;
+
+    class ComponentArrayInterface
+    {
+        public:
+            virtual ~ComponentArrayInterface() = default;
+    };
+
+    template<typename T>
+    class ComponentArray : public ComponentArrayInterface
+    {
+        public:
+            void insert(Entity entity, T component)
+            {
+                std::size_t index = components_.size();
+                entity_to_index_[entity] = index;
+                index_to_entity_[index] = entity;
+                components_.push_back(component);
+            }
+
+            T& get(Entity entity)
+            {
+                return components_[entity_to_index_[entity]];
+            }
+
+        private:
+            std::vector<T> components_;
+            std::unordered_map<Entity, std::size_t> entity_to_index_;
+            std::unordered_map<std::size_t, Entity> index_to_entity_;
+    };
+
+    class ComponentManager
+    {
+        public:
+            template<typename T>
+            void register_component()
+            {
+                component_arrays_[typeid(T).name()] = std::make_shared<ComponentArray<T>>();
+            }
+
+            template<typename T>
+            void add_component(Entity entity, T component)
+            {
+                get_component_array_<T>()->insert(entity, component);
+            }
+
+            template<typename T>
+            T& get_component(Entity entity)
+            {
+                return get_component_array_<T>()->get(entity);
+            }
+
+        private:
+            template<typename T>
+            std::shared_ptr<ComponentArray<T>> get_component_array_()
+            {
+                return std::static_pointer_cast<ComponentArray<T>>(component_arrays_[typeid(T).name()]);
+            }
+
+            std::unordered_map<const char*, std::shared_ptr<ComponentArrayInterface>> component_arrays_;
+    };
+
+    struct PhysicsScene
+    {
+        ComponentManager components;
+        std::set<Entity> entities;
+
+        void update(float dt)
+        {
+            using namespace engine;
+
+            for (auto const& entity : entities)
+            {
+                auto& rigid_body = components.get_component<component::RigidBody>(entity);
+                auto& transform = components.get_component<component::Transform>(entity);
+                auto const& gravity = components.get_component<component::Gravity>(entity);
+
+                transform.position += rigid_body.velocity * dt;
+                rigid_body.velocity += gravity.force * dt;
+            }
+        }
+    };
+
+    inline std::unique_ptr<PhysicsScene> make_physics_scene(std::size_t count)
+    {
+        using namespace engine;
+
+        auto scene = std::make_unique<PhysicsScene>();
+        scene->components.register_component<component::Transform>();
+        scene->components.register_component<component::RigidBody>();
+        scene->components.register_component<component::Gravity>();
+
+        component::Gravity gravity;
+        gravity.force = Diligent::float3(0, -9.81f, 0);
+
+        for (Entity entity = 0; entity < count; ++entity)
+        {
+            scene->components.add_component(entity, component::Transform {});
+            scene->components.add_component(entity, component::RigidBody {});
+            scene->components.add_component(entity, gravity);
+            scene->entities.insert(entity);
+        }
+
+        return scene;
+    }
+}
+
+int main()
+{
+    constexpr float DT = 1.0f / 60.0f;
+    constexpr std::size_t RUNS = 21;
+
+    std::cout << std::setw(10) << "entities" << std::setw(14) << "maps ms" << std::setw(14) << "sparse ms" << std::setw(10) << "speedup" << "\n";
+
+    for (std::size_t count : { 5000, 50000, 500000 })
+    {
+        auto maps = baseline::make_physics_scene(count);
+        double maps_ms = benchmark::median_ms(RUNS, [&]() { maps->update(DT); });
+
+        benchmark::PhysicsScene sparse = benchmark::make_physics_scene(count);
+        double sparse_ms = benchmark::median_ms(RUNS, [&]() { sparse.physics_system->update(DT); });
+
+        std::cout << std::setw(10) << count
+                  << std::fixed << std::setprecision(3)
+                  << std::setw(14) << maps_ms
+                  << std::setw(14) << sparse_ms
+                  << std::setprecision(1) << std::setw(9) << maps_ms / sparse_ms << "x" << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
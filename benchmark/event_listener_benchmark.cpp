@@ -0,0 +1,84 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "event.hpp"
+#include "event_delegate.hpp"
+#include "event_manager.hpp"
+#include "event_types.hpp"
+
+// Subscribe / unsubscribe soak: 1M frames, each subscribing short-lived
+// listeners next to long-lived ones, half of them unsubscribing from inside
+// their callback, the rest when their handle is reset at the end of the frame.
+// The cost of a frame must stay flat - no listener slot left behind.
+
+using namespace engine::event;
+
+struct Listener
+{
+    double sum = 0.0;
+    EventListener handle;
+    bool once = false;
+
+    void handler(Event& event)
+    {
+        sum += event.get<MousePositionEvent>().x;
+
+        if (once)
+            handle.reset();
+    }
+};
+
+int main()
+{
+    constexpr std::size_t FRAMES = 1000000;
+    constexpr std::size_t WINDOW = 100000;
+    constexpr std::size_t LONG_LIVED = 16;
+    constexpr std::size_t SHORT_LIVED = 8;
+    constexpr std::size_t SENDS = 4;
+
+    EventManager manager;
+
+    std::vector<Listener> long_lived(LONG_LIVED);
+    for (Listener& listener : long_lived)
+        listener.handle = manager.add_listener(MOUSE_POSITION, EventDelegate::bind<&Listener::handler>(&listener));
+
+    std::vector<Listener> short_lived(SHORT_LIVED);
+
+    std::cout << std::setw(12) << "frames" << std::setw(16) << "ns / frame" << "\n";
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (std::size_t frame = 1; frame <= FRAMES; ++frame)
+    {
+        for (std::size_t i = 0; i < SHORT_LIVED; ++i)
+        {
+            short_lived[i].once = i % 2 == 0;
+            short_lived[i].handle = manager.add_listener(MOUSE_POSITION, EventDelegate::bind<&Listener::handler>(&short_lived[i]));
+        }
+
+        Event event(MousePositionEvent { 1.0, 0.0 });
+        for (std::size_t i = 0; i < SENDS; ++i)
+            manager.send_event(event);
+
+        for (Listener& listener : short_lived)
+            listener.handle.reset();
+
+        if (frame % WINDOW == 0)
+        {
+            auto now = std::chrono::steady_clock::now();
+            double ns = std::chrono::duration<double, std::nano>(now - start).count() / WINDOW;
+            start = now;
+
+            std::cout << std::setw(12) << frame << std::fixed << std::setprecision(1) << std::setw(16) << ns << std::endl;
+        }
+    }
+
+    // Every long-lived listener got every event
+    if (long_lived[0].sum != double(FRAMES * SENDS))
+        std::cerr << "lost events" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "benchmark.hpp"
+
+#include "utils_job_system.hpp"
+
+// Scaling of the job system with the number of threads: a compute-bound
+// parallel_for split in many small jobs, and the overhead of a serialized
+// chain of dependent jobs (the scheduler's shape when every system conflicts).
+
+using namespace engine::utils;
+
+static double work(std::size_t begin, std::size_t end)
+{
+    double sum = 0.0;
+    for (std::size_t i = begin; i < end; ++i)
+        sum += std::sqrt(double(i)) * std::sin(double(i));
+
+    return sum;
+}
+
+static void run_chain(JobSystem& job_system, std::size_t length)
+{
+    std::vector<std::unique_ptr<JobCounter>> pending;
+    for (std::size_t i = 0; i < length; ++i)
+        pending.push_back(std::make_unique<JobCounter>(i == 0 ? 0 : 1));
+
+    JobCounter done;
+
+    for (std::size_t i = 0; i < length; ++i)
+    {
+        job_system.schedule([&, i]()
+        {
+            if (i + 1 < length)
+                job_system.decrement(*pending[i + 1]);
+        }, &done, pending[i].get());
+    }
+
+    job_system.wait(done);
+}
+
+int main()
+{
+    constexpr std::size_t ITEMS = 1 << 22;
+    constexpr std::size_t GRAIN = 1 << 12;
+    constexpr std::size_t CHAIN = 64;
+    constexpr std::size_t RUNS = 11;
+
+    std::cout << std::setw(10) << "threads" << std::setw(16) << "for_each ms" << std::setw(10) << "speedup"
+              << std::setw(20) << "chain us / job" << "\n";
+
+    double single_ms = 0.0;
+
+    for (std::size_t threads : benchmark::thread_counts())
+    {
+        JobSystem job_system(threads - 1);
+
+        std::vector<double> sums(ITEMS / GRAIN);
+        double for_each_ms = benchmark::median_ms(RUNS, [&]()
+        {
+            job_system.parallel_for(0, ITEMS, GRAIN, [&](std::size_t begin, std::size_t end)
+            {
+                sums[begin / GRAIN] = work(begin, end);
+            });
+        });
+
+        double chain_ms = benchmark::median_ms(RUNS, [&]() { run_chain(job_system, CHAIN); });
+
+        if (threads == 1)
+            single_ms = for_each_ms;
+
+        std::cout << std::setw(10) << threads
+                  << std::fixed << std::setprecision(3) << std::setw(16) << for_each_ms
+                  << std::setprecision(2) << std::setw(9) << single_ms / for_each_ms << "x"
+                  << std::setprecision(3) << std::setw(20) << 1000.0 * chain_ms / CHAIN << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "benchmark.hpp"
+
+#include "event.hpp"
+#include "event_types.hpp"
+
+#include "utils_mpsc_ring.hpp"
+
+// Throughput of posting events from several producer threads to one
+// consumer: the MPSCRing behind EventManager::post_event against a
+// mutex-guarded vector swapped out by the consumer.
+
+using engine::event::Event;
+
+namespace baseline
+{
+    class LockedQueue
+    {
+        public:
+            bool try_push(Event const& event)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+
+                events_.push_back(event);
+
+                return true;
+            }
+
+            template<typename F>
+            std::size_t drain(F&& fn)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    draining_.swap(events_);
+                }
+
+                for (Event& event : draining_)
+                    fn(event);
+
+                std::size_t count = draining_.size();
+                draining_.clear();
+
+                return count;
+            }
+
+        private:
+            std::mutex mutex_;
+            std::vector<Event> events_;
+            std::vector<Event> draining_;
+    };
+}
+
+// Millions of events a second through the queue, producers posting EVENTS
+// each and retrying when it is full
+template<typename Queue>
+double throughput(Queue& queue, std::size_t producer_count)
+{
+    constexpr std::size_t EVENTS = 500000;
+
+    std::atomic<bool> start{false};
+    std::vector<std::thread> producers;
+
+    for (std::size_t producer = 0; producer < producer_count; ++producer)
+    {
+        producers.emplace_back([&]()
+        {
+            while (!start.load(std::memory_order_acquire))
+                std::this_thread::yield();
+
+            Event event(engine::event::MousePositionEvent { 1.0, 2.0 });
+            for (std::size_t i = 0; i < EVENTS; ++i)
+                while (!queue.try_push(event))
+                    std::this_thread::yield();
+        });
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+
+    double sum = 0.0;
+    std::size_t popped = 0;
+
+    while (popped < producer_count * EVENTS)
+    {
+        std::size_t drained = queue.drain([&](Event& event) { sum += event.get<engine::event::MousePositionEvent>().x; });
+        popped += drained;
+
+        if (drained == 0)
+            std::this_thread::yield();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    for (std::thread& thread : producers)
+        thread.join();
+
+    if (sum != double(popped))
+        std::cerr << "lost events" << std::endl;
+
+    return double(popped) / seconds / 1e6;
+}
+
+int main()
+{
+    std::cout << std::setw(10) << "producers" << std::setw(16) << "ring M/s" << std::setw(16) << "mutex M/s" << "\n";
+
+    for (std::size_t producers : benchmark::thread_counts())
+    {
+        engine::utils::MPSCRing<Event> ring(4096);
+        baseline::LockedQueue locked;
+
+        double ring_rate = throughput(ring, producers);
+        double locked_rate = throughput(locked, producers);
+
+        std::cout << std::setw(10) << producers
+                  << std::fixed << std::setprecision(2)
+                  << std::setw(16) << ring_rate
+                  << std::setw(16) << locked_rate << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
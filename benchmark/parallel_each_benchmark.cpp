@@ -0,0 +1,41 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include "benchmark.hpp"
+
+#include "utils_job_system.hpp"
+
+// Scaling of PhysicsSystem::update - a cached query walked with
+// parallel_each - over 1M bodies, from one thread to every hardware thread.
+
+int main()
+{
+    constexpr float DT = 1.0f / 60.0f;
+    constexpr std::size_t BODIES = 1000000;
+    constexpr std::size_t RUNS = 21;
+
+    std::cout << std::setw(10) << "threads" << std::setw(14) << "update ms" << std::setw(10) << "speedup" << std::setw(14) << "efficiency" << "\n";
+
+    double single_ms = 0.0;
+
+    for (std::size_t threads : benchmark::thread_counts())
+    {
+        engine::utils::JobSystem job_system(threads - 1);
+
+        benchmark::PhysicsScene scene = benchmark::make_physics_scene(BODIES, engine::ecs::ECSStorageMode::SPARSE_SET, &job_system);
+        double update_ms = benchmark::median_ms(RUNS, [&]() { scene.physics_system->update(DT); });
+
+        if (threads == 1)
+            single_ms = update_ms;
+
+        double speedup = single_ms / update_ms;
+
+        std::cout << std::setw(10) << threads
+                  << std::fixed << std::setprecision(3) << std::setw(14) << update_ms
+                  << std::setprecision(2) << std::setw(9) << speedup << "x"
+                  << std::setprecision(0) << std::setw(13) << 100.0 * speedup / double(threads) << "%" << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "benchmark.hpp"
+
+#include "spatial_sort_system.hpp"
+
+// Cost of a SpatialSortSystem pass over bodies scattered in a cube: done in
+// one frame, as when the whole sort ran when the pass started, against the
+// worst frame of a pass spread over frames by the default budget. Also times
+// PhysicsSystem::update while a pass reorders its arrays (its cached query
+// only fetches its indices again) and once the pass is over.
+
+// A PhysicsScene (see benchmark.hpp) whose bodies are also spatially sorted
+struct SortScene
+{
+    std::unique_ptr<engine::Coordinator> coordinator;
+    std::shared_ptr<engine::system::PhysicsSystem> physics_system;
+    std::shared_ptr<engine::system::SpatialSortSystem> sort_system;
+};
+
+static SortScene make_sort_scene(std::size_t count)
+{
+    using namespace engine;
+
+    SortScene scene;
+    scene.coordinator = std::make_unique<Coordinator>();
+    scene.coordinator->init();
+
+    scene.coordinator->register_component<component::Transform>();
+    scene.coordinator->register_component<component::RigidBody>();
+    scene.coordinator->register_component<component::Gravity>();
+
+    ecs::ECSMask mask;
+    mask.set(scene.coordinator->get_component_type<component::Transform>());
+    mask.set(scene.coordinator->get_component_type<component::Gravity>());
+    mask.set(scene.coordinator->get_component_type<component::RigidBody>());
+
+    scene.physics_system = scene.coordinator->register_system<system::PhysicsSystem>(*scene.coordinator);
+    scene.coordinator->set_system_mask<system::PhysicsSystem>(mask);
+    scene.physics_system->init();
+
+    scene.sort_system = scene.coordinator->register_system<system::SpatialSortSystem>(*scene.coordinator);
+    scene.coordinator->set_system_mask<system::SpatialSortSystem>(mask);
+
+    component::Gravity gravity;
+    gravity.force = Diligent::float3(0, -9.81f, 0);
+
+    ecs::ECSPrefab body;
+    body.set(component::Transform {})
+        .set(component::RigidBody {})
+        .set(gravity);
+
+    scene.coordinator->instantiate(body, count);
+
+    // Scattered in a cube, in no particular memory order
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> coordinate(-500.0f, 500.0f);
+
+    auto* transforms = scene.coordinator->get_component_array<component::Transform>();
+    for (std::size_t i = 0; i < transforms->size(); ++i)
+        transforms->components()[i].position = Diligent::float3(coordinate(random), coordinate(random), coordinate(random));
+
+    Input input;
+    input.gravity = true;
+
+    event::Event event(event::InputEvent { input });
+    scene.coordinator->send_event(event);
+
+    return scene;
+}
+
+int main()
+{
+    constexpr float DT = 1.0f / 60.0f;
+    constexpr std::size_t RUNS = 21;
+
+    std::cout << std::setw(10) << "entities"
+              << std::setw(14) << "one frame ms"
+              << std::setw(14) << "worst ms"
+              << std::setw(10) << "frames"
+              << std::setw(16) << "physics ms"
+              << std::setw(14) << "sorted ms" << "\n";
+
+    for (std::size_t count : { 100000, 1000000 })
+    {
+        // The whole pass in the first frame
+        SortScene whole = make_sort_scene(count);
+        whole.sort_system->set_budget(std::numeric_limits<std::size_t>::max());
+        double whole_ms = benchmark::median_ms(1, [&]() { whole.sort_system->update(DT); });
+
+        // The same pass under the default budget, a physics step every frame
+        SortScene bounded = make_sort_scene(count);
+        double worst_ms = 0.0;
+        std::vector<double> physics_ms;
+
+        do
+        {
+            auto start = std::chrono::steady_clock::now();
+            bounded.sort_system->update(DT);
+            worst_ms = std::max(worst_ms, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+            physics_ms.push_back(benchmark::median_ms(1, [&]() { bounded.physics_system->update(DT); }));
+        }
+        while (bounded.sort_system->is_sorting());
+
+        std::nth_element(physics_ms.begin(), physics_ms.begin() + physics_ms.size() / 2, physics_ms.end());
+        double sorted_ms = benchmark::median_ms(RUNS, [&]() { bounded.physics_system->update(DT); });
+
+        std::cout << std::setw(10) << count
+                  << std::fixed << std::setprecision(3)
+                  << std::setw(14) << whole_ms
+                  << std::setw(14) << worst_ms
+                  << std::setw(10) << physics_ms.size()
+                  << std::setw(16) << physics_ms[physics_ms.size() / 2]
+                  << std::setw(14) << sorted_ms << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,75 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "benchmark.hpp"
+
+#include "ecs_state_history.hpp"
+
+// Rollback of 10k falling bodies: every frame the world state is saved and
+// pushed to an ECSStateHistory, then the world goes back 8 frames - restoring
+// the state kept 8 pushes ago - and simulates them again, saving each of them.
+// The restore and the 8 frames of re-simulation have to fit in one 16 ms frame.
+// Also prints the memory held by the history against 9 whole states.
+
+int main()
+{
+    constexpr float DT = 1.0f / 60.0f;
+    constexpr std::size_t BODIES = 10000;
+    constexpr std::size_t FRAMES_BACK = 8;
+    constexpr std::size_t RUNS = 21;
+    constexpr double BUDGET_MS = 16.0;
+
+    benchmark::PhysicsScene scene = benchmark::make_physics_scene(BODIES);
+    engine::Coordinator& coordinator = *scene.coordinator;
+
+    engine::ecs::ECSStateHistory history(FRAMES_BACK + 1);
+    std::vector<std::byte> state;
+
+    auto step = [&]()
+    {
+        scene.physics_system->update(DT);
+
+        state.clear();
+        coordinator.save_state(state);
+        history.push(state);
+    };
+
+    // Fill the history
+    for (std::size_t frame = 0; frame <= FRAMES_BACK; ++frame)
+        step();
+
+    double step_ms = benchmark::median_ms(RUNS, step);
+
+    double rollback_ms = benchmark::median_ms(RUNS, [&]()
+    {
+        std::vector<std::byte> past;
+        history.get(FRAMES_BACK, past);
+        history.rewind(FRAMES_BACK);
+
+        if (!coordinator.restore_state(past))
+            std::cerr << "restore failed" << std::endl;
+
+        for (std::size_t frame = 0; frame < FRAMES_BACK; ++frame)
+            step();
+    });
+
+    std::cout << std::setw(10) << "bodies"
+              << std::setw(14) << "frame ms"
+              << std::setw(14) << "rollback ms"
+              << std::setw(12) << "budget"
+              << std::setw(14) << "history KB"
+              << std::setw(14) << "states KB" << "\n";
+
+    std::cout << std::setw(10) << BODIES
+              << std::fixed << std::setprecision(3)
+              << std::setw(14) << step_ms
+              << std::setw(14) << rollback_ms
+              << std::setprecision(0)
+              << std::setw(11) << 100.0 * rollback_ms / BUDGET_MS << "%"
+              << std::setw(14) << double(history.get_memory_usage()) / 1024.0
+              << std::setw(14) << double(history.capacity() * state.size()) / 1024.0 << std::endl;
+
+    return EXIT_SUCCESS;
+}
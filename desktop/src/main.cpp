@@ -1,4 +1,6 @@
+#include <cstring>
 #include <iostream>
+#include <string>
 
 #include "engine.hpp"
 #include "platform.hpp"
@@ -10,8 +12,20 @@
 std::shared_ptr<desktop::window::WindowManager> window_manager = {};
 std::shared_ptr<engine::Engine> engine_manager = {};
 
+// Usage: desktop [--record <path>]
+//
+// --record writes the events and frame timesteps of the session to path, to be
+// replayed by the headless runner.
 int main(int argc, char *argv[])
 {
+    std::string record_path;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            record_path = argv[++i];
+    }
+
     window_manager = std::make_unique<desktop::window::WindowManager>();
     window_manager->initialize("Loading...", 1280, 720);
 
@@ -21,6 +35,9 @@ int main(int argc, char *argv[])
 
     engine_manager->init(native_window, get_resource_path());
 
+    if (!record_path.empty())
+        engine_manager->start_recording();
+
     window_manager->send_default_events();
 
     double last_time_fps = glfwGetTime();
@@ -68,6 +85,9 @@ int main(int argc, char *argv[])
         nb_frames++;
     }
 
+    if (!record_path.empty() && !engine_manager->stop_recording(record_path))
+        std::cerr << "Could not write the recording to " << record_path << std::endl;
+
     engine_manager->shutdown();
     window_manager->shutdown();
 
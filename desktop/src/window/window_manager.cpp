@@ -92,36 +92,32 @@ namespace desktop
                     break;
             }
 
-            engine::event::Event input_event(engine::event::INPUT);
-            input_event.set_parameter(engine::event::input::PARAMETER, window_manager->input);
-            engine_manager->send_event(input_event);
+            engine::event::Event input_event(engine::event::InputEvent { window_manager->input });
+            engine_manager->post_event(input_event);
         }
 
         static void framebuffer_size_callback_(GLFWwindow *w, int width, int height)
         {
             assert(engine_manager);
 
-            engine::event::Event resize_event(engine::event::RESIZE);
-		    resize_event.set_parameter(engine::event::resize::WIDTH, width);
-            resize_event.set_parameter(engine::event::resize::HEIGHT, height);
-            engine_manager->send_event(resize_event);
+            engine::event::Event resize_event(engine::event::ResizeEvent { width, height });
+            engine_manager->post_event(resize_event);
         }
 
         static void mouse_callback_(GLFWwindow *w, double x, double y)
         {
             assert(engine_manager);
 
-            engine::event::Event mouse_position_event(engine::event::MOUSE_POSITION);
-            mouse_position_event.set_parameter(engine::event::mouse_position::X, x);
-            mouse_position_event.set_parameter(engine::event::mouse_position::Y, y);
-            engine_manager->send_event(mouse_position_event);
+            engine::event::Event mouse_position_event(engine::event::MousePositionEvent { x, y });
+            engine_manager->post_event(mouse_position_event);
         }
 
-        void scroll_callback_(GLFWwindow* w, double xoffset, double yoffset)
+        static void scroll_callback_(GLFWwindow *w, double xoffset, double yoffset)
         {
-            //fov -= yoffset;
-            //fov = utils::clamp(fov, 45.0, 90.0);
-            //graphics_engine->set_fov(fov);
+            assert(engine_manager);
+
+            engine::event::Event scroll_offset_event(engine::event::ScrollOffsetEvent { xoffset, yoffset });
+            engine_manager->post_event(scroll_offset_event);
         }
 
         /// MARK: - Public methods
@@ -171,18 +167,14 @@ namespace desktop
             int width = 0, height = 0;
             glfwGetFramebufferSize(window_, &width, &height);
 
-            engine::event::Event resize_event(engine::event::RESIZE);
-		    resize_event.set_parameter(engine::event::resize::WIDTH, width);
-            resize_event.set_parameter(engine::event::resize::HEIGHT, height);
-            engine_manager->send_event(resize_event);
+            engine::event::Event resize_event(engine::event::ResizeEvent { width, height });
+            engine_manager->post_event(resize_event);
 
             double x, y;
             glfwGetCursorPos(window_, &x, &y);
 
-            engine::event::Event mouse_position_event(engine::event::MOUSE_POSITION);
-            mouse_position_event.set_parameter(engine::event::mouse_position::X, x);
-            mouse_position_event.set_parameter(engine::event::mouse_position::Y, y);
-            engine_manager->send_event(mouse_position_event);
+            engine::event::Event mouse_position_event(engine::event::MousePositionEvent { x, y });
+            engine_manager->post_event(mouse_position_event);
         }
 
         void WindowManager::process_events()
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "ecs_types.hpp"
+
+namespace engine
+{
+    namespace component
+    {
+        // Resource: the camera entity the scene is rendered from
+        struct ActiveCamera
+        {
+            ecs::ECSEntity entity = ecs::NULL_ENTITY;
+        };
+    }
+}
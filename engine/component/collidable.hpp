@@ -1,14 +1,12 @@
 #pragma once
 
-#include <BasicMath.hpp>
-
 namespace engine
 {
     namespace component
     {
+        // Tag: no data, only a bit in the entity mask
         struct Collidable
         {
-        
-        }
+        };
     }
-}
\ No newline at end of file
+}
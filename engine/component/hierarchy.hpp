@@ -0,0 +1,17 @@
+#pragma once
+
+#include "ecs_types.hpp"
+
+namespace engine
+{
+    namespace component
+    {
+        // Attaches an entity to a parent: its Transform becomes relative to the
+        // parent's world transform. Entities without it (or whose parent has no
+        // world transform) are roots.
+        struct Hierarchy
+        {
+            ecs::ECSEntity parent = ecs::NULL_ENTITY;
+        };
+    }
+}
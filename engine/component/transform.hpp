@@ -9,8 +9,9 @@ namespace engine
 		struct Transform
 		{
 			Diligent::float3 position;
+			// Euler angles in radians, applied around X, then Y, then Z
 			Diligent::float3 rotation;
-			Diligent::float3 scale;
+			Diligent::float3 scale = Diligent::float3(1, 1, 1);
 		};
 	}
 }
\ No newline at end of file
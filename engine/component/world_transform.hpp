@@ -0,0 +1,16 @@
+#pragma once
+
+#include <BasicMath.hpp>
+
+namespace engine
+{
+    namespace component
+    {
+        // Local-to-world matrix (row vectors) computed from the Transform of the
+        // entity and of its ancestors by the TransformHierarchySystem
+        struct WorldTransform
+        {
+            Diligent::float4x4 matrix = Diligent::float4x4::Identity();
+        };
+    }
+}
@@ -1,26 +1,44 @@
 #pragma once
 
+#include <algorithm>
+#include <cassert>
+#include <fstream>
 #include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "ecs_types.hpp"
+#include "ecs_command_buffer.hpp"
 #include "ecs_component_manager.hpp"
 #include "ecs_entity_manager.hpp"
+#include "ecs_observer_manager.hpp"
+#include "ecs_prefab.hpp"
+#include "ecs_resource_manager.hpp"
+#include "ecs_snapshot.hpp"
+#include "ecs_state_history.hpp"
 #include "ecs_system_manager.hpp"
+#include "ecs_view.hpp"
 
 #include "event.hpp"
 #include "event_manager.hpp"
 
+#include "utils_mapped_file.hpp"
+
 namespace engine
 {
     class Coordinator
     {
         public:
-            void init()
+            void init(ecs::ECSStorageMode storage_mode = ecs::ECSStorageMode::SPARSE_SET)
             {
                 // Create pointers to each manager
-                component_manager_ = std::make_unique<ecs::ECSComponentManager>();
+                component_manager_ = std::make_unique<ecs::ECSComponentManager>(storage_mode);
                 entity_manager_ = std::make_unique<ecs::ECSEntityManager>();
                 system_manager_ = std::make_unique<ecs::ECSSystemManager>();
+                resource_manager_ = std::make_unique<ecs::ECSResourceManager>();
+                observer_manager_ = std::make_unique<ecs::ECSObserverManager>();
                 event_manager_ = std::make_unique<event::EventManager>();
             }
 
@@ -31,11 +49,60 @@ namespace engine
                 return entity_manager_->create_entity();
             }
 
+            std::vector<ecs::ECSEntity> create_entities(std::size_t count)
+            {
+                std::vector<ecs::ECSEntity> entities(count);
+                entity_manager_->create_entities(count, entities.data());
+
+                return entities;
+            }
+
+            // Stale handles - destroyed already, their index maybe recycled - are
+            // ignored, so they can never destroy another entity
             void destroy_entity(ecs::ECSEntity entity)
             {
+                if (!entity_manager_->is_alive(entity))
+                    return;
+
+                // Only the component arrays and systems selected by the mask are touched
+                auto mask = entity_manager_->get_mask(entity);
+
                 entity_manager_->destroy_entity(entity);
-                component_manager_->entity_destroyed(entity);
-                system_manager_->entity_destroyed(entity);
+                component_manager_->entity_destroyed(entity, mask);
+                system_manager_->entity_destroyed(entity, mask);
+                observer_manager_->record(ecs::ECSObserverEvent::REMOVE, entity, mask);
+            }
+
+            // Stale handles are ignored as well, and a handle listed twice destroys
+            // its entity once. Every component array and every system list loses
+            // all of its entities of the batch at once.
+            void destroy_entities(ecs::ECSEntity const* entities, std::size_t count)
+            {
+                std::vector<ecs::ECSEntity> destroyed(count);
+                std::vector<ecs::ECSMask> masks(count);
+
+                count = entity_manager_->destroy_entities(entities, count, destroyed.data(), masks.data());
+
+                component_manager_->entities_destroyed(destroyed.data(), masks.data(), count);
+                system_manager_->entities_destroyed(destroyed.data(), masks.data(), count);
+
+                for (std::size_t i = 0; i < count; ++i)
+                    observer_manager_->record(ecs::ECSObserverEvent::REMOVE, destroyed[i], masks[i]);
+            }
+
+            void destroy_entities(std::vector<ecs::ECSEntity> const& entities)
+            {
+                destroy_entities(entities.data(), entities.size());
+            }
+
+            bool is_alive(ecs::ECSEntity entity) const
+            {
+                return entity_manager_->is_alive(entity);
+            }
+
+            std::uint32_t get_entity_count() const
+            {
+                return entity_manager_->get_entity_count();
             }
 
             /// MARK: - Component methods
@@ -44,18 +111,25 @@ namespace engine
             void register_component()
             {
                 component_manager_->register_component<T>();
+
+                // In-process states identify types, tags included, by their ID
+                if constexpr (std::is_trivially_copyable<T>::value)
+                    state_.add<T>(component_manager_->get_component_type<T>());
             }
 
+            // Tags (empty types) are added without a value: add_component<Tag>(entity)
             template<typename T>
-            void add_component(ecs::ECSEntity entity, T component)
+            void add_component(ecs::ECSEntity entity, T component = {})
             {
                 component_manager_->add_component<T>(entity, component);
 
-                auto mask = entity_manager_->get_mask(entity);
+                auto old_mask = entity_manager_->get_mask(entity);
+                auto mask = old_mask;
                 mask.set(component_manager_->get_component_type<T>(), true);
                 entity_manager_->set_mask(entity, mask);
 
-                system_manager_->entity_mask_changed(entity, mask);
+                system_manager_->entity_mask_changed(entity, old_mask, mask);
+                observer_manager_->record(ecs::ECSObserverEvent::ADD, entity, mask & ~old_mask);
             }
 
             template<typename T>
@@ -63,11 +137,13 @@ namespace engine
             {
                 component_manager_->remove_component<T>(entity);
 
-                auto mask = entity_manager_->get_mask(entity);
+                auto old_mask = entity_manager_->get_mask(entity);
+                auto mask = old_mask;
                 mask.set(component_manager_->get_component_type<T>(), false);
                 entity_manager_->set_mask(entity, mask);
 
-                system_manager_->entity_mask_changed(entity, mask);
+                system_manager_->entity_mask_changed(entity, old_mask, mask);
+                observer_manager_->record(ecs::ECSObserverEvent::REMOVE, entity, old_mask & ~mask);
             }
 
             template<typename T>
@@ -82,12 +158,379 @@ namespace engine
                 return component_manager_->get_component_type<T>();
             }
 
-            /// MARK: - System methods
+            // Typed view over the entities owning all the given components, e.g.
+            // view<Transform, RigidBody, const Gravity>().without<Camera>()
+            template<typename... Ts>
+            ecs::ECSView<Ts...> view()
+            {
+                return ecs::ECSView<Ts...>(entity_manager_.get(), component_manager_.get());
+            }
+
+            // Sparse-set storage only: the packed array of a component type
+            template<typename T>
+            ecs::ECSComponentArray<T>* get_component_array()
+            {
+                return component_manager_->get_component_array<T>();
+            }
+
+            // Reorders the packed array of a component type - not while iterating it
+            template<typename T>
+            void swap_component_slots(std::uint32_t a, std::uint32_t b)
+            {
+                component_manager_->swap_slots<T>(a, b);
+            }
+
+            // Bumped every time the set of entities owning a T changes
+            template<typename T>
+            std::uint32_t get_component_version()
+            {
+                return component_manager_->get_version(component_manager_->get_component_type<T>());
+            }
+
+            // Changes whenever components of type T may have moved in their packed
+            // array: with the version above, and with every swap of slots
+            template<typename T>
+            std::uint32_t get_component_order_version()
+            {
+                return component_manager_->get_order_version(component_manager_->get_component_type<T>());
+            }
+
+            ecs::ECSStorageMode get_storage_mode() const
+            {
+                return component_manager_->get_storage_mode();
+            }
 
+            // Archetype storage only: streams through every chunk holding all the given components
+            template<typename... Ts, typename F>
+            void each_chunk(F&& fn)
+            {
+                component_manager_->each_chunk<Ts...>(std::forward<F>(fn));
+            }
+
+            template<typename T>
+            bool has_component(ecs::ECSEntity entity) const
+            {
+                return entity_manager_->get_mask(entity).test(component_manager_->get_component_type<T>());
+            }
+
+            /// MARK: - Resource methods
+
+            template<typename T>
+            T& set_resource(T resource)
+            {
+                return resource_manager_->set_resource<T>(std::move(resource));
+            }
+
+            template<typename T>
+            T& get_resource()
+            {
+                return resource_manager_->get_resource<T>();
+            }
+
+            template<typename T>
+            bool has_resource() const
+            {
+                return resource_manager_->has_resource<T>();
+            }
+
+            template<typename T>
+            void remove_resource()
+            {
+                resource_manager_->remove_resource<T>();
+            }
+
+            /// MARK: - Observer methods
+
+            // Observers are called by dispatch_observers with every entity the
+            // component was added to / removed from / changed on since the last
+            // dispatch, never from within add_component or remove_component.
+            // Observing changes enables change tracking for the type.
+            template<typename T>
+            void on_add(ecs::ECSObserver observer)
+            {
+                observer_manager_->add_observer<T>(ecs::ECSObserverEvent::ADD, *component_manager_, std::move(observer));
+            }
+
+            template<typename T>
+            void on_remove(ecs::ECSObserver observer)
+            {
+                observer_manager_->add_observer<T>(ecs::ECSObserverEvent::REMOVE, *component_manager_, std::move(observer));
+            }
+
+            template<typename T>
+            void on_change(ecs::ECSObserver observer)
+            {
+                observer_manager_->add_observer<T>(ecs::ECSObserverEvent::CHANGE, *component_manager_, std::move(observer));
+            }
+
+            // Sync point: delivers the batches recorded since the last call.
+            // Must not run while systems are updating.
+            void dispatch_observers()
+            {
+                observer_manager_->dispatch(*component_manager_, *entity_manager_);
+            }
+
+            /// MARK: - Change tracking methods
+
+            // Opt-in, per component type. Components written through a view (unless
+            // declared const) or flagged with mark_changed are recorded at the
+            // current tick, as are the ones added.
             template<typename T>
-            std::shared_ptr<T> register_system()
+            void enable_change_tracking()
+            {
+                component_manager_->enable_change_tracking<T>();
+            }
+
+            ecs::ECSTick get_tick() const
+            {
+                return component_manager_->get_tick();
+            }
+
+            // A consumer keeps the tick returned by its last call and asks for the
+            // changes since then:
+            //     ecs::ECSTick since = last_tick_;
+            //     last_tick_ = coordinator->advance_tick();
+            //     coordinator->each_changed<Transform>(since, ...);
+            ecs::ECSTick advance_tick()
             {
-                return system_manager_->register_system<T>();
+                return component_manager_->advance_tick();
+            }
+
+            template<typename T>
+            void mark_changed(ecs::ECSEntity entity)
+            {
+                component_manager_->mark_changed<T>(entity);
+            }
+
+            template<typename T, typename F>
+            void each_changed(ecs::ECSTick since, F&& fn)
+            {
+                component_manager_->each_changed<T>(since, std::forward<F>(fn));
+            }
+
+            /// MARK: - Command buffer methods
+
+            // Applies the commands recorded in a buffer in one batch, then clears it.
+            // Commands are grouped per entity (sorted by entity index, keeping the
+            // recording order within an entity) so that each entity gets its final
+            // mask computed once and its system membership updated once.
+            void flush(ecs::ECSCommandBuffer& commands)
+            {
+                auto const& list = commands.get_commands();
+
+                // Give the provisional entities their real handles, and every
+                // command its target once
+                std::vector<ecs::ECSEntity> created = create_entities(commands.get_created_count());
+                std::vector<ecs::ECSEntity> targets(list.size());
+
+                for (std::size_t i = 0; i < list.size(); ++i)
+                {
+                    ecs::ECSEntity entity = list[i].entity;
+
+                    if (ecs::ECSCommandBuffer::is_provisional(entity))
+                    {
+                        // Provisional handles index the entities this buffer created
+                        // since it was last flushed. Any other one is dropped in
+                        // release builds.
+                        assert(ecs::entity_index(entity) < created.size() && "Provisional entity from another command buffer.");
+
+                        entity = ecs::entity_index(entity) < created.size() ? created[ecs::entity_index(entity)] : ecs::NULL_ENTITY;
+                    }
+
+                    targets[i] = entity;
+                }
+
+                // Grouped by index, stale handles apart from the living one
+                std::vector<std::uint32_t> order(list.size());
+                for (std::uint32_t i = 0; i < order.size(); ++i)
+                    order[i] = i;
+
+                std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b)
+                {
+                    ecs::ECSEntityIndex index_a = ecs::entity_index(targets[a]);
+                    ecs::ECSEntityIndex index_b = ecs::entity_index(targets[b]);
+
+                    return index_a < index_b || (index_a == index_b && targets[a] < targets[b]);
+                });
+
+                std::size_t i = 0;
+                while (i < order.size())
+                {
+                    ecs::ECSEntity entity = targets[order[i]];
+
+                    // Commands targeting an entity destroyed in the meantime are dropped
+                    if (!entity_manager_->is_alive(entity))
+                    {
+                        while (i < order.size() && targets[order[i]] == entity)
+                            ++i;
+
+                        continue;
+                    }
+
+                    auto old_mask = entity_manager_->get_mask(entity);
+                    auto mask = old_mask;
+                    bool destroyed = false;
+
+                    for (; i < order.size() && targets[order[i]] == entity; ++i)
+                    {
+                        auto const& command = list[order[i]];
+
+                        if (destroyed)
+                            continue;
+
+                        switch (command.type)
+                        {
+                            case ecs::ECSCommandType::ADD_COMPONENT:
+                                command.apply(*component_manager_, entity, commands.get_payload(command.payload));
+                                mask.set(command.component, true);
+                                break;
+                            case ecs::ECSCommandType::REMOVE_COMPONENT:
+                                command.apply(*component_manager_, entity, nullptr);
+                                mask.set(command.component, false);
+                                break;
+                            case ecs::ECSCommandType::DESTROY:
+                                destroyed = true;
+                                break;
+                            default:
+                                break;
+                        }
+                    }
+
+                    if (destroyed)
+                    {
+                        // Systems and observers only know about the mask the entity
+                        // had before the batch
+                        entity_manager_->destroy_entity(entity);
+                        component_manager_->entity_destroyed(entity, mask);
+                        system_manager_->entity_destroyed(entity, old_mask);
+                        observer_manager_->record(ecs::ECSObserverEvent::REMOVE, entity, old_mask);
+                    }
+                    else if (mask != old_mask)
+                    {
+                        entity_manager_->set_mask(entity, mask);
+                        system_manager_->entity_mask_changed(entity, old_mask, mask);
+                        observer_manager_->record(ecs::ECSObserverEvent::ADD, entity, mask & ~old_mask);
+                        observer_manager_->record(ecs::ECSObserverEvent::REMOVE, entity, old_mask & ~mask);
+                    }
+                }
+
+                commands.clear();
+            }
+
+            /// MARK: - Prefab methods
+
+            // Creates count entities owning the components of the prefab, set to its
+            // values, writing their handles to out. Every component array and every
+            // system list grows once for all of them.
+            void instantiate(ecs::ECSPrefab const& prefab, std::size_t count, ecs::ECSEntity* out)
+            {
+                ecs::ECSMask mask = prefab.get_mask();
+
+                entity_manager_->create_entities(count, out);
+                for (std::size_t i = 0; i < count; ++i)
+                    entity_manager_->set_mask(out[i], mask);
+
+                component_manager_->instantiate(out, count, prefab);
+                system_manager_->entities_created(out, count, mask);
+                observer_manager_->record(ecs::ECSObserverEvent::ADD, out, count, mask);
+            }
+
+            std::vector<ecs::ECSEntity> instantiate(ecs::ECSPrefab const& prefab, std::size_t count)
+            {
+                std::vector<ecs::ECSEntity> entities(count);
+                instantiate(prefab, count, entities.data());
+
+                return entities;
+            }
+
+            ecs::ECSEntity instantiate(ecs::ECSPrefab const& prefab)
+            {
+                ecs::ECSEntity entity;
+                instantiate(prefab, 1, &entity);
+
+                return entity;
+            }
+
+            /// MARK: - Snapshot methods
+
+            // Appends a binary snapshot of the world (entities and component data,
+            // not systems, resources or observers) to out
+            void save_snapshot(ecs::ECSSnapshot const& snapshot, std::vector<std::byte>& out)
+            {
+                snapshot.write(*entity_manager_, *component_manager_, out);
+            }
+
+            bool save_snapshot(ecs::ECSSnapshot const& snapshot, std::string const& path)
+            {
+                std::vector<std::byte> data;
+                save_snapshot(snapshot, data);
+
+                std::ofstream file(path, std::ios::binary | std::ios::trunc);
+                file.write(reinterpret_cast<char const*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+                return static_cast<bool>(file);
+            }
+
+            // Replaces the world with a snapshot and rebuilds the entity lists of the
+            // systems. Observers are not notified. Returns false, leaving the world
+            // untouched, if the data is not a valid snapshot.
+            bool load_snapshot(ecs::ECSSnapshot const& snapshot, std::byte const* data, std::size_t size)
+            {
+                if (!snapshot.read(data, size, *entity_manager_, *component_manager_))
+                    return false;
+
+                std::vector<ecs::ECSEntity> entities;
+                std::vector<ecs::ECSMask> masks;
+                entities.reserve(entity_manager_->get_entity_count());
+                masks.reserve(entity_manager_->get_entity_count());
+
+                entity_manager_->each_entity([&](ecs::ECSEntity entity)
+                {
+                    entities.push_back(entity);
+                    masks.push_back(entity_manager_->get_mask(entity));
+                });
+
+                system_manager_->assign_entities(entities.data(), masks.data(), entities.size());
+
+                return true;
+            }
+
+            // The file is memory-mapped, so the component arrays are copied straight
+            // from the page cache
+            bool load_snapshot(ecs::ECSSnapshot const& snapshot, std::string const& path)
+            {
+                utils::MappedFile file;
+
+                return file.open(path) && load_snapshot(snapshot, file.data(), file.size());
+            }
+
+            // Appends the state of the world to out: the entity allocator, the masks
+            // and the packed component arrays, copied in bulk. Meant for rollback
+            // within the running process (see ECSStateHistory); every registered
+            // component type holding data must be trivially copyable.
+            void save_state(std::vector<std::byte>& out)
+            {
+                save_snapshot(state_, out);
+            }
+
+            bool restore_state(std::byte const* data, std::size_t size)
+            {
+                return load_snapshot(state_, data, size);
+            }
+
+            bool restore_state(std::vector<std::byte> const& state)
+            {
+                return restore_state(state.data(), state.size());
+            }
+
+            /// MARK: - System methods
+
+            // Systems usually take the coordinator they run in as first argument:
+            // register_system<T>(coordinator, ...)
+            template<typename T, typename... Args>
+            std::shared_ptr<T> register_system(Args&&... args)
+            {
+                return system_manager_->register_system<T>(std::forward<Args>(args)...);
             }
 
             template<typename T>
@@ -98,9 +541,10 @@ namespace engine
 
             /// MARK: - Event methods
 
-            void add_event_listener(event::EventId event_id, std::function<void(event::Event&)> const& listener)
+            // The listener is subscribed as long as the returned handle lives
+            event::EventListener add_event_listener(event::EventId event_id, event::EventDelegate listener)
             {
-                event_manager_->add_listener(event_id, listener);
+                return event_manager_->add_listener(event_id, listener);
             }
 
             void send_event(event::Event& event)
@@ -113,10 +557,47 @@ namespace engine
                 event_manager_->send_event(event_id);
             }
 
+            // Queued events are delivered by dispatch_events (see EventManager).
+            // Any thread; false if the event was dropped, the queue being full
+            bool post_event(event::Event const& event)
+            {
+                return event_manager_->post_event(event);
+            }
+
+            // Freezes the events the next dispatch delivers (see EventManager)
+            void collect_events()
+            {
+                event_manager_->collect_events();
+            }
+
+            void dispatch_events()
+            {
+                event_manager_->dispatch_events();
+            }
+
+            template<typename T>
+            void coalesce_events_replace()
+            {
+                event_manager_->coalesce_replace<T>();
+            }
+
+            template<typename T>
+            void coalesce_events_accumulate()
+            {
+                event_manager_->coalesce_accumulate<T>();
+            }
+
         private:
+            // Declared first, so destroyed last: systems unsubscribe their
+            // event listeners when the system manager destroys them
+            std::unique_ptr<event::EventManager> event_manager_;
             std::unique_ptr<ecs::ECSComponentManager> component_manager_;
             std::unique_ptr<ecs::ECSEntityManager> entity_manager_;
             std::unique_ptr<ecs::ECSSystemManager> system_manager_;
-            std::unique_ptr<event::EventManager> event_manager_;
+            std::unique_ptr<ecs::ECSResourceManager> resource_manager_;
+            std::unique_ptr<ecs::ECSObserverManager> observer_manager_;
+
+            // Every registered component type, for save_state and restore_state
+            ecs::ECSSnapshot state_{};
     };
 }
\ No newline at end of file
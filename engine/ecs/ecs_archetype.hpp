@@ -0,0 +1,401 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "ecs_types.hpp"
+
+namespace engine
+{
+    namespace ecs
+    {
+        // Layout information of a component type, needed to store it in a chunk column.
+        // Components stored in archetypes are moved around with memcpy, so they
+        // must be trivially copyable. Tags have a size of 0 and take no room.
+        struct ECSComponentInfo
+        {
+            std::uint32_t size = 0;
+            std::uint32_t alignment = 0;
+        };
+
+        // All the entities sharing the same mask.
+        // Rows are packed in fixed-size chunks, and every chunk holds one column
+        // per component type (plus one for the entities), so systems can stream
+        // through a chunk linearly.
+        class ECSArchetype
+        {
+            public:
+                static constexpr std::size_t CHUNK_SIZE = 16 * 1024;
+                static constexpr std::size_t COLUMN_ALIGNMENT = 64;
+
+                ECSArchetype(ECSMask mask, std::array<ECSComponentInfo, MAX_COMPONENTS> const& infos)
+                    : mask_(mask)
+                {
+                    std::size_t row_size = sizeof(ECSEntity);
+                    for (ECSComponentType type = 0; type < MAX_COMPONENTS; ++type)
+                    {
+                        if (mask_.test(type))
+                        {
+                            assert(infos[type].alignment != 0 && "Component not registered before use.");
+                            row_size += infos[type].size;
+                        }
+                    }
+
+                    // Start from the ideal capacity and shrink it until the
+                    // cache-line aligned columns fit in a chunk
+                    capacity_ = static_cast<std::uint32_t>(CHUNK_SIZE / row_size);
+                    while (!layout_(infos))
+                        --capacity_;
+
+                    assert(capacity_ > 0 && "Archetype row does not fit in a chunk.");
+
+                    add_edges_.fill(nullptr);
+                    remove_edges_.fill(nullptr);
+                }
+
+                ECSMask get_mask() const
+                {
+                    return mask_;
+                }
+
+                std::size_t size() const
+                {
+                    return size_;
+                }
+
+                std::size_t chunk_count() const
+                {
+                    return chunks_.size();
+                }
+
+                std::uint32_t chunk_capacity() const
+                {
+                    return capacity_;
+                }
+
+                // Number of rows used in a chunk - every chunk but the last one is full
+                std::uint32_t chunk_size(std::size_t chunk) const
+                {
+                    std::size_t begin = chunk * capacity_;
+
+                    return static_cast<std::uint32_t>(std::min<std::size_t>(capacity_, size_ - begin));
+                }
+
+                ECSEntity* entities(std::size_t chunk)
+                {
+                    return reinterpret_cast<ECSEntity*>(chunks_[chunk]->data);
+                }
+
+                void* column(std::size_t chunk, ECSComponentType type)
+                {
+                    assert(mask_.test(type) && "Component not part of archetype.");
+
+                    return chunks_[chunk]->data + offsets_[type];
+                }
+
+                ECSEntity entity_at(std::size_t row)
+                {
+                    return entities(row / capacity_)[row % capacity_];
+                }
+
+                void* at(std::size_t row, ECSComponentType type)
+                {
+                    return static_cast<std::byte*>(column(row / capacity_, type)) + (row % capacity_) * sizes_[type];
+                }
+
+                // Appends a row for the entity (components left uninitialized) and returns it.
+                std::uint32_t push(ECSEntity entity)
+                {
+                    if (size_ == chunks_.size() * capacity_)
+                        chunks_.push_back(std::make_unique<Chunk>());
+
+                    std::size_t row = size_++;
+                    entities(row / capacity_)[row % capacity_] = entity;
+
+                    return static_cast<std::uint32_t>(row);
+                }
+
+                // Copy the last row into the removed one to maintain density.
+                // Returns the entity that now occupies the row, which is the removed
+                // entity itself when it was the last row.
+                ECSEntity swap_remove(std::size_t row)
+                {
+                    std::size_t last = size_ - 1;
+                    ECSEntity moved = entity_at(last);
+
+                    if (row != last)
+                    {
+                        entities(row / capacity_)[row % capacity_] = moved;
+
+                        for (ECSComponentType type = 0; type < MAX_COMPONENTS; ++type)
+                            if (mask_.test(type))
+                                std::memcpy(at(row, type), at(last, type), sizes_[type]);
+                    }
+
+                    --size_;
+
+                    // Release the last chunk once empty
+                    if (size_ == (chunks_.size() - 1) * capacity_)
+                        chunks_.pop_back();
+
+                    return moved;
+                }
+
+                // Cached archetype transitions when a component type is added or removed
+                ECSArchetype*& add_edge(ECSComponentType type)
+                {
+                    return add_edges_[type];
+                }
+
+                ECSArchetype*& remove_edge(ECSComponentType type)
+                {
+                    return remove_edges_[type];
+                }
+
+            private:
+                struct Chunk
+                {
+                    alignas(COLUMN_ALIGNMENT) std::byte data[CHUNK_SIZE];
+                };
+
+                // Compute the column offsets for the current capacity.
+                // Returns false if the columns do not fit in a chunk.
+                bool layout_(std::array<ECSComponentInfo, MAX_COMPONENTS> const& infos)
+                {
+                    std::size_t offset = capacity_ * sizeof(ECSEntity);
+
+                    for (ECSComponentType type = 0; type < MAX_COMPONENTS; ++type)
+                    {
+                        if (!mask_.test(type) || infos[type].size == 0)
+                            continue;
+
+                        std::size_t alignment = std::max<std::size_t>(infos[type].alignment, COLUMN_ALIGNMENT);
+                        offset = (offset + alignment - 1) / alignment * alignment;
+
+                        offsets_[type] = static_cast<std::uint32_t>(offset);
+                        sizes_[type] = infos[type].size;
+
+                        offset += capacity_ * infos[type].size;
+                    }
+
+                    return offset <= CHUNK_SIZE;
+                }
+
+                ECSMask mask_;
+
+                // Byte offset and element size of each component column inside a chunk
+                std::array<std::uint32_t, MAX_COMPONENTS> offsets_{};
+                std::array<std::uint32_t, MAX_COMPONENTS> sizes_{};
+
+                // Rows per chunk
+                std::uint32_t capacity_ = 0;
+
+                // Total rows across all chunks
+                std::size_t size_ = 0;
+
+                std::vector<std::unique_ptr<Chunk>> chunks_{};
+
+                std::array<ECSArchetype*, MAX_COMPONENTS> add_edges_;
+                std::array<ECSArchetype*, MAX_COMPONENTS> remove_edges_;
+        };
+
+        // Archetype-based component storage.
+        // Keeps track of which archetype (and row) every entity lives in, and
+        // moves entities between archetypes whenever their mask changes.
+        class ECSArchetypeStorage
+        {
+            public:
+                void register_component(ECSComponentType type, ECSComponentInfo info)
+                {
+                    infos_[type] = info;
+                }
+
+                void add(ECSEntity entity, ECSComponentType type, void const* component)
+                {
+                    Location& location = location_(entity);
+
+                    assert((!location.archetype || location.version == entity_version(entity)) && "Adding a component to a stale entity.");
+
+                    ECSArchetype* target = nullptr;
+                    if (location.archetype)
+                    {
+                        assert(!location.archetype->get_mask().test(type) && "Component added to same entity more than once.");
+
+                        ECSArchetype*& edge = location.archetype->add_edge(type);
+                        if (!edge)
+                            edge = get_archetype_(ECSMask(location.archetype->get_mask()).set(type));
+
+                        target = edge;
+                    }
+                    else
+                    {
+                        target = get_archetype_(ECSMask().set(type));
+                    }
+
+                    move_(entity, target);
+
+                    std::memcpy(target->at(location_(entity).row, type), component, infos_[type].size);
+                }
+
+                // Places entities owning no component yet straight in the archetype
+                // of the mask, copying the same value of each component type (indexed
+                // by type) into all of their rows
+                void insert(ECSEntity const* entities, std::size_t count, ECSMask mask, std::array<void const*, MAX_COMPONENTS> const& components)
+                {
+                    ECSArchetype* target = get_archetype_(mask);
+
+                    // Columns to fill, tags having none
+                    std::vector<ECSComponentType> columns;
+                    for (ECSComponentType type = 0; type < MAX_COMPONENTS; ++type)
+                        if (mask.test(type) && infos_[type].size > 0)
+                            columns.push_back(type);
+
+                    for (std::size_t i = 0; i < count; ++i)
+                    {
+                        Location& location = location_(entities[i]);
+
+                        assert(!location.archetype && "Instantiating an entity that already has components.");
+
+                        std::uint32_t row = target->push(entities[i]);
+                        location = { target, row, entity_version(entities[i]) };
+
+                        for (ECSComponentType type : columns)
+                            std::memcpy(target->at(row, type), components[type], infos_[type].size);
+                    }
+                }
+
+                void remove(ECSEntity entity, ECSComponentType type)
+                {
+                    Location& location = location_(entity);
+
+                    assert(location.archetype && location.version == entity_version(entity) && location.archetype->get_mask().test(type) && "Removing non-existent component.");
+
+                    ECSMask mask = location.archetype->get_mask();
+                    mask.reset(type);
+
+                    if (mask.none())
+                        return entity_destroyed(entity);
+
+                    ECSArchetype*& edge = location.archetype->remove_edge(type);
+                    if (!edge)
+                        edge = get_archetype_(mask);
+
+                    move_(entity, edge);
+                }
+
+                void* get(ECSEntity entity, ECSComponentType type)
+                {
+                    Location& location = location_(entity);
+
+                    assert(location.archetype && location.version == entity_version(entity) && location.archetype->get_mask().test(type) && "Retrieving non-existent component.");
+
+                    return location.archetype->at(location.row, type);
+                }
+
+                // Ignores stale handles: the index may hold a newer entity by now
+                void entity_destroyed(ECSEntity entity)
+                {
+                    ECSEntityIndex index = entity_index(entity);
+
+                    if (index >= locations_.size() || !locations_[index].archetype || locations_[index].version != entity_version(entity))
+                        return;
+
+                    remove_row_(locations_[index]);
+                    locations_[index] = {};
+                }
+
+                // Calls fn(archetype, chunk) for every non-empty chunk whose archetype
+                // contains all the components of the mask.
+                template<typename F>
+                void for_each_chunk(ECSMask mask, F&& fn)
+                {
+                    for (auto& archetype : archetypes_)
+                    {
+                        if ((archetype->get_mask() & mask) != mask)
+                            continue;
+
+                        for (std::size_t chunk = 0; chunk < archetype->chunk_count(); ++chunk)
+                            fn(*archetype, chunk);
+                    }
+                }
+
+            private:
+                // Keyed by entity index, and holding the version of the entity
+                // placed there so that stale handles never match it
+                struct Location
+                {
+                    ECSArchetype* archetype = nullptr;
+                    std::uint32_t row = 0;
+                    ECSEntityVersion version = 0;
+                };
+
+                Location& location_(ECSEntity entity)
+                {
+                    ECSEntityIndex index = entity_index(entity);
+
+                    if (index >= locations_.size())
+                        locations_.resize(index + 1);
+
+                    return locations_[index];
+                }
+
+                ECSArchetype* get_archetype_(ECSMask mask)
+                {
+                    auto it = archetype_lookup_.find(mask);
+                    if (it != archetype_lookup_.end())
+                        return it->second;
+
+                    archetypes_.push_back(std::make_unique<ECSArchetype>(mask, infos_));
+                    archetype_lookup_.insert({mask, archetypes_.back().get()});
+
+                    return archetypes_.back().get();
+                }
+
+                // Moves an entity (and the components both archetypes share) to a new archetype.
+                void move_(ECSEntity entity, ECSArchetype* target)
+                {
+                    Location& location = location_(entity);
+
+                    std::uint32_t row = target->push(entity);
+
+                    if (location.archetype)
+                    {
+                        ECSMask shared = location.archetype->get_mask() & target->get_mask();
+
+                        for (ECSComponentType type = 0; type < MAX_COMPONENTS; ++type)
+                            if (shared.test(type))
+                                std::memcpy(target->at(row, type), location.archetype->at(location.row, type), infos_[type].size);
+
+                        remove_row_(location);
+                    }
+
+                    location = { target, row, entity_version(entity) };
+                }
+
+                // Removes a row and patches the location of the entity moved into it.
+                void remove_row_(Location const& location)
+                {
+                    ECSEntity moved = location.archetype->swap_remove(location.row);
+
+                    locations_[entity_index(moved)].row = location.row;
+                }
+
+                std::array<ECSComponentInfo, MAX_COMPONENTS> infos_{};
+
+                // Location of every entity, indexed by entity index
+                std::vector<Location> locations_{};
+
+                // Archetypes in creation order, for stable iteration
+                std::vector<std::unique_ptr<ECSArchetype>> archetypes_{};
+
+                // Map from a mask to its archetype
+                std::unordered_map<ECSMask, ECSArchetype*> archetype_lookup_{};
+        };
+    }
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "ecs_types.hpp"
+#include "ecs_type_id.hpp"
+#include "ecs_component_manager.hpp"
+
+namespace engine
+{
+    namespace ecs
+    {
+        enum class ECSCommandType : std::uint8_t
+        {
+            CREATE,
+            DESTROY,
+            ADD_COMPONENT,
+            REMOVE_COMPONENT
+        };
+
+        struct ECSCommand
+        {
+            using Apply = void (*)(ECSComponentManager&, ECSEntity, void const*);
+
+            ECSEntity entity;
+            ECSCommandType type;
+            ECSComponentType component;
+            // Offset of the component value in the payload arena (add only)
+            std::uint32_t payload;
+            // Applies the command to the component storage (add/remove only)
+            Apply apply;
+        };
+
+        // Records structural changes (create/add/remove/destroy) to be applied later
+        // in one batch by Coordinator::flush.
+        // Recording does not touch the world at all, so a command buffer can be
+        // filled from a worker thread - one buffer per thread, flushed on the
+        // thread owning the world.
+        // Entities created through a buffer get a provisional handle, which can be
+        // used by the following commands of the same buffer and is replaced by a
+        // real handle at flush time.
+        class ECSCommandBuffer
+        {
+            public:
+                static constexpr ECSEntityVersion PROVISIONAL_VERSION = ~ECSEntityVersion(0);
+
+                static bool is_provisional(ECSEntity entity)
+                {
+                    return entity_version(entity) == PROVISIONAL_VERSION;
+                }
+
+                ECSEntity create_entity()
+                {
+                    ECSEntity entity = make_entity(nb_created_++, PROVISIONAL_VERSION);
+                    commands_.push_back({ entity, ECSCommandType::CREATE, 0, 0, nullptr });
+
+                    return entity;
+                }
+
+                void destroy_entity(ECSEntity entity)
+                {
+                    commands_.push_back({ entity, ECSCommandType::DESTROY, 0, 0, nullptr });
+                }
+
+                template<typename T>
+                void add_component(ECSEntity entity, T component)
+                {
+                    // Component values are copied into a byte arena
+                    static_assert(std::is_trivially_copyable<T>::value, "Buffered components must be trivially copyable.");
+                    static_assert(alignof(T) <= alignof(std::max_align_t), "Buffered components must not be over-aligned.");
+
+                    std::size_t offset = (payloads_.size() + alignof(T) - 1) / alignof(T) * alignof(T);
+                    payloads_.resize(offset + sizeof(T));
+                    std::memcpy(payloads_.data() + offset, &component, sizeof(T));
+
+                    commands_.push_back({
+                        entity,
+                        ECSCommandType::ADD_COMPONENT,
+                        component_type_<T>(),
+                        static_cast<std::uint32_t>(offset),
+                        [](ECSComponentManager& manager, ECSEntity entity, void const* payload)
+                        {
+                            T value;
+                            std::memcpy(&value, payload, sizeof(T));
+                            manager.add_component<T>(entity, value);
+                        }
+                    });
+                }
+
+                template<typename T>
+                void remove_component(ECSEntity entity)
+                {
+                    commands_.push_back({
+                        entity,
+                        ECSCommandType::REMOVE_COMPONENT,
+                        component_type_<T>(),
+                        0,
+                        [](ECSComponentManager& manager, ECSEntity entity, void const*)
+                        {
+                            manager.remove_component<T>(entity);
+                        }
+                    });
+                }
+
+                std::vector<ECSCommand> const& get_commands() const
+                {
+                    return commands_;
+                }
+
+                void const* get_payload(std::uint32_t offset) const
+                {
+                    return payloads_.data() + offset;
+                }
+
+                // Number of provisional entities created by this buffer
+                std::uint32_t get_created_count() const
+                {
+                    return nb_created_;
+                }
+
+                bool empty() const
+                {
+                    return commands_.empty();
+                }
+
+                void clear()
+                {
+                    commands_.clear();
+                    payloads_.clear();
+                    nb_created_ = 0;
+                }
+
+            private:
+                template<typename T>
+                static ECSComponentType component_type_()
+                {
+                    return static_cast<ECSComponentType>(ECSTypeId<ECSComponentFamily>::get<T>());
+                }
+
+                std::vector<ECSCommand> commands_{};
+
+                // Arena holding the recorded component values
+                std::vector<std::byte> payloads_{};
+
+                std::uint32_t nb_created_ = 0;
+        };
+    }
+}
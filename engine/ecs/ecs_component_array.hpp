@@ -1,10 +1,17 @@
 #pragma once
 
-#include <array>
+#include <algorithm>
+#include <atomic>
 #include <cassert>
-#include <unordered_map>
+#include <cstring>
+#include <deque>
+#include <utility>
+#include <vector>
 
 #include "ecs_types.hpp"
+#include "ecs_sparse_set.hpp"
+
+#include "utils_aligned_allocator.hpp"
 
 namespace engine
 {
@@ -13,80 +20,336 @@ namespace engine
         // The one instance of virtual inheritance in the entire implementation.
         // An interface is needed so that the ComponentManager
         // can tell a generic ComponentArray that an entity has been destroyed
-        // and that it needs to update its array mappings.
+        // and that it needs to update its array mappings, or fill it from a
+        // type-erased prefab value.
         class ECSComponentArrayInterface
         {
             public:
                 virtual ~ECSComponentArrayInterface() = default;
-                virtual void entity_destroyed(ECSEntity entity) = 0;
+                // Returns true if the entity had a component in this array
+                virtual bool entity_destroyed(ECSEntity entity) = 0;
+                // Removes the components of destroyed entities, all owning one
+                virtual void entities_destroyed(ECSEntity const* entities, std::size_t count) = 0;
+                // Gives each of the entities a copy of the component pointed to
+                virtual void insert_copies(ECSEntity const* entities, std::size_t count, void const* component) = 0;
         };
 
+        // Sparse-set storage: the entities owning a component are kept in a
+        // packed array parallel to the packed array of components, and a paged
+        // sparse index maps an entity to its slot in both.
+        //
+        // Change tracking is opt-in. Once enabled, every slot records the tick
+        // it was last added or written at, and every block of CHANGE_BLOCK_SIZE
+        // slots records the newest tick of its slots, so looking for changes
+        // skips whole unchanged blocks.
         template<typename T>
         class ECSComponentArray : public ECSComponentArrayInterface
         {
             public:
+                static constexpr std::uint32_t CHANGE_BLOCK_SIZE = 64;
+
                 void insert(ECSEntity entity, T component)
                 {
-                    assert(entity_to_index_.find(entity) == entity_to_index_.end() && "Component added to same entity more than once.");
+                    // Put new entry at end of both packed arrays
+                    std::uint32_t index = entities_.insert(entity);
+                    components_.push_back(std::move(component));
+
+                    if (clock_)
+                    {
+                        ticks_.push_back(0);
+                        if (index % CHANGE_BLOCK_SIZE == 0)
+                            block_ticks_.emplace_back(0);
+
+                        mark_changed_at(index);
+                    }
+                }
+
+                // Appends count entities, each getting a copy of the component.
+                // The packed arrays grow once for all of them.
+                void insert(ECSEntity const* entities, std::size_t count, T const& component)
+                {
+                    std::size_t first = components_.size();
+
+                    entities_.insert(entities, count);
+                    components_.insert(components_.end(), count, component);
+
+                    if (clock_)
+                    {
+                        ECSTick tick = clock_->load(std::memory_order_relaxed);
 
-                    // Put new entry at end and update the maps
-                    unsigned int index = nb_components_;
-                    entity_to_index_[entity] = index;
-                    index_to_entity_[index] = entity;
-                    components_[index] = component;
-                    ++nb_components_;
+                        ticks_.resize(first + count, tick);
+                        while (block_ticks_.size() * CHANGE_BLOCK_SIZE < ticks_.size())
+                            block_ticks_.emplace_back(tick);
+
+                        // The block the new slots started in was already there
+                        if (count > 0)
+                            raise_block_tick_(static_cast<std::uint32_t>(first), tick);
+                    }
+                }
+
+                void insert_copies(ECSEntity const* entities, std::size_t count, void const* component) override
+                {
+                    insert(entities, count, *static_cast<T const*>(component));
                 }
 
                 void remove(ECSEntity entity)
                 {
-                    assert(entity_to_index_.find(entity) != entity_to_index_.end() && "Removing non-existent component.");
+                    // Apply the same swap-remove as the entity set to maintain density
+                    std::uint32_t index = entities_.remove(entity);
+                    std::uint32_t last = static_cast<std::uint32_t>(components_.size() - 1);
 
-                    // Copy element at end into deleted element's place to maintain density
-                    unsigned int index_removed_entity = entity_to_index_[entity];
-                    unsigned int index_last_entity = nb_components_ - 1;
-                    components_[index_removed_entity] = components_[index_last_entity];
+                    if (index != last)
+                        components_[index] = std::move(components_.back());
 
-                    // Update map to point to moved spot
-                    ECSEntity entityOfLastElement = index_to_entity_[index_last_entity];
-                    entity_to_index_[entityOfLastElement] = index_removed_entity;
-                    entity_to_index_[index_removed_entity] = entityOfLastElement;
+                    components_.pop_back();
 
-                    entity_to_index_.erase(entity);
-                    entity_to_index_.erase(index_last_entity);
+                    if (clock_)
+                    {
+                        // The moved slot keeps its tick, and its new block must not
+                        // look older than it
+                        ticks_[index] = ticks_[last];
+                        raise_block_tick_(index, ticks_[index]);
 
-                    --nb_components_;
+                        ticks_.pop_back();
+                        if (last % CHANGE_BLOCK_SIZE == 0)
+                            block_ticks_.pop_back();
+                    }
+                }
+
+                // Removes the components of count entities at once, none listed
+                // twice. The packed arrays shrink once, the holes below their new
+                // size filled with the last components.
+                void remove(ECSEntity const* entities, std::size_t count)
+                {
+                    std::size_t size = components_.size() - count;
+
+                    entities_.remove(entities, count, [&](std::uint32_t from, std::uint32_t to)
+                    {
+                        components_[to] = std::move(components_[from]);
+
+                        if (clock_)
+                        {
+                            ticks_[to] = ticks_[from];
+                            raise_block_tick_(to, ticks_[to]);
+                        }
+                    });
+
+                    components_.erase(components_.begin() + size, components_.end());
+
+                    if (clock_)
+                    {
+                        ticks_.resize(size);
+                        while (block_ticks_.size() * CHANGE_BLOCK_SIZE >= size + CHANGE_BLOCK_SIZE)
+                            block_ticks_.pop_back();
+                    }
+                }
+
+                // Exchanges two slots of the packed arrays, e.g. to reorder them.
+                // Entity handles and change ticks move along.
+                void swap_slots(std::uint32_t a, std::uint32_t b)
+                {
+                    entities_.swap(a, b);
+                    std::swap(components_[a], components_[b]);
+
+                    if (clock_)
+                    {
+                        std::swap(ticks_[a], ticks_[b]);
+                        raise_block_tick_(a, ticks_[a]);
+                        raise_block_tick_(b, ticks_[b]);
+                    }
                 }
 
                 T& get(ECSEntity entity)
                 {
-                    assert(entity_to_index_.find(entity) != entity_to_index_.end() && "Retrieving non-existent component.");
+                    assert(entities_.contains(entity) && "Retrieving non-existent component.");
 
                     // Return a reference to the entity's component
-                    return components_[entity_to_index_[entity]];
+                    return components_[entities_.index_of(entity)];
+                }
+
+                // Same as get, but records the component as changed
+                T& write(ECSEntity entity)
+                {
+                    assert(entities_.contains(entity) && "Retrieving non-existent component.");
+
+                    std::uint32_t index = entities_.index_of(entity);
+                    mark_changed_at(index);
+
+                    return components_[index];
                 }
 
-                void entity_destroyed(ECSEntity entity) override
+                bool contains(ECSEntity entity) const
+                {
+                    return entities_.contains(entity);
+                }
+
+                bool entity_destroyed(ECSEntity entity) override
                 {
                     // Remove the entity's component if it existed
-                    if (entity_to_index_.find(entity) != entity_to_index_.end())
-                        remove(entity);
+                    if (!entities_.contains(entity))
+                        return false;
+
+                    remove(entity);
+
+                    return true;
+                }
+
+                void entities_destroyed(ECSEntity const* entities, std::size_t count) override
+                {
+                    remove(entities, count);
+                }
+
+                // Replaces the content of the array with count components, copied
+                // in bulk - components must be trivially copyable
+                void assign(ECSEntity const* entities, void const* components, std::size_t count)
+                {
+                    entities_.assign(entities, count);
+
+                    components_.resize(count);
+                    if (count > 0)
+                        std::memcpy(static_cast<void*>(components_.data()), components, count * sizeof(T));
+
+                    // Everything loaded counts as changed at the current tick
+                    if (clock_)
+                    {
+                        ECSTick tick = clock_->load(std::memory_order_relaxed);
+
+                        ticks_.assign(count, tick);
+                        block_ticks_.clear();
+                        for (std::size_t i = 0; i < count; i += CHANGE_BLOCK_SIZE)
+                            block_ticks_.emplace_back(tick);
+                    }
+                }
+
+                void reserve(std::size_t capacity)
+                {
+                    entities_.reserve(capacity);
+                    components_.reserve(capacity);
+                }
+
+                std::size_t size() const
+                {
+                    return components_.size();
+                }
+
+                // Packed arrays, valid for indices [0, size())
+                ECSEntity const* entities() const
+                {
+                    return entities_.data();
+                }
+
+                T* components()
+                {
+                    return components_.data();
+                }
+
+                std::uint32_t index_of(ECSEntity entity) const
+                {
+                    return entities_.index_of(entity);
+                }
+
+                /// MARK: - Change tracking
+
+                // Starts recording changes, reading the current tick from clock.
+                // Every existing component counts as changed at the current tick.
+                void enable_change_tracking(std::atomic<ECSTick> const* clock)
+                {
+                    assert(clock && "Change tracking needs a clock.");
+
+                    if (clock_)
+                        return;
+
+                    clock_ = clock;
+
+                    ECSTick tick = clock_->load(std::memory_order_relaxed);
+
+                    ticks_.assign(components_.size(), tick);
+                    for (std::size_t i = 0; i < components_.size(); i += CHANGE_BLOCK_SIZE)
+                        block_ticks_.emplace_back(tick);
+                }
+
+                bool is_change_tracking_enabled() const
+                {
+                    return clock_ != nullptr;
+                }
+
+                // Records the slot as changed at the current tick. Does nothing when
+                // change tracking is disabled. Safe to call concurrently for
+                // different slots.
+                void mark_changed_at(std::uint32_t index)
+                {
+                    if (!clock_)
+                        return;
+
+                    ECSTick tick = clock_->load(std::memory_order_relaxed);
+
+                    ticks_[index] = tick;
+                    raise_block_tick_(index, tick);
+                }
+
+                // Tick a slot was last changed at
+                ECSTick get_tick_at(std::uint32_t index) const
+                {
+                    assert(clock_ && "Change tracking is disabled.");
+
+                    return ticks_[index];
+                }
+
+                // Calls fn(entity, T&) for every component added or changed at or
+                // after tick since, skipping the blocks with no such component.
+                // Components handed out this way are not marked as changed.
+                template<typename F>
+                void each_changed(ECSTick since, F&& fn)
+                {
+                    assert(clock_ && "Change tracking is disabled.");
+
+                    std::size_t count = components_.size();
+
+                    for (std::size_t block = 0; block < block_ticks_.size(); ++block)
+                    {
+                        if (block_ticks_[block].load(std::memory_order_relaxed) < since)
+                            continue;
+
+                        std::size_t begin = block * CHANGE_BLOCK_SIZE;
+                        std::size_t end = std::min<std::size_t>(begin + CHANGE_BLOCK_SIZE, count);
+
+                        for (std::size_t i = begin; i < end; ++i)
+                            if (ticks_[i] >= since)
+                                fn(entities_[i], components_[i]);
+                    }
                 }
 
             private:
+                void raise_block_tick_(std::uint32_t index, ECSTick tick)
+                {
+                    // Ticks only grow, so checking first keeps concurrent writers
+                    // of a block from bouncing its cache line around
+                    std::atomic<ECSTick>& block = block_ticks_[index / CHANGE_BLOCK_SIZE];
+
+                    if (block.load(std::memory_order_relaxed) < tick)
+                        block.store(tick, std::memory_order_relaxed);
+                }
+
+                // Packed array of entities and sparse index from an entity to its slot.
+                ECSSparseSet entities_{};
+
                 // The packed array of components (of generic type T),
-                // set to a specified maximum amount, matching the maximum number
-                // of entities allowed to exist simultaneously, so that each entity
-                // has a unique spot.
-                std::array<T, MAX_ENTITIES> components_;
+                // parallel to the packed array of entities. It starts on a cache
+                // line so that ranges split on cache-line multiples never share one.
+                std::vector<T, utils::AlignedAllocator<T>> components_{};
 
-                // Map from an entity ID to an array index.
-                std::unordered_map<ECSEntity, unsigned int> entity_to_index_;
+                // Current tick, owned by the ComponentManager - null while change
+                // tracking is disabled
+                std::atomic<ECSTick> const* clock_ = nullptr;
 
-                // Map from an array index to an entity ID.
-                std::unordered_map<unsigned int, ECSEntity> index_to_entity_;
+                // Tick each slot was last changed at, parallel to the packed arrays.
+                // Cache-line aligned too, parallel ranges writing to their own lines.
+                std::vector<ECSTick, utils::AlignedAllocator<ECSTick>> ticks_{};
 
-                // Total size of valid entries in the array.
-                unsigned int nb_components_;
+                // Newest tick of each block of slots. Written concurrently by
+                // parallel iteration, hence atomic (and a deque, which never needs
+                // to move its elements).
+                std::deque<std::atomic<ECSTick>> block_ticks_{};
         };
     }
 }
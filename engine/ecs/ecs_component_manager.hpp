@@ -1,11 +1,18 @@
 #pragma once
 
-#include <typeinfo>
+#include <array>
+#include <atomic>
+#include <cassert>
 #include <memory>
-#include <unordered_map>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "ecs_types.hpp"
+#include "ecs_type_id.hpp"
+#include "ecs_archetype.hpp"
 #include "ecs_component_array.hpp"
+#include "ecs_prefab.hpp"
 
 namespace engine
 {
@@ -14,85 +21,354 @@ namespace engine
         class ECSComponentManager
         {
             public:
+                explicit ECSComponentManager(ECSStorageMode storage_mode = ECSStorageMode::SPARSE_SET)
+                    : storage_mode_(storage_mode)
+                {}
+
+                ECSStorageMode get_storage_mode() const
+                {
+                    return storage_mode_;
+                }
+
                 template<typename T>
                 void register_component()
                 {
-                    const char* type_name = typeid(T).name();
+                    ECSComponentType type = type_id_<T>();
 
-                    assert(component_types_.find(type_name) == component_types_.end() && "Registering component type more than once.");
+                    assert(!registered_.test(type) && "Registering component type more than once.");
 
-                    // Add this component type to the component type map
-                    component_types_.insert({type_name, next_component_type_});
+                    // Mark this component type as registered
+                    registered_.set(type);
 
-                    // Create a ComponentArray pointer and add it to the component arrays map
-                    component_arrays_.insert({type_name, std::make_shared<ECSComponentArray<T>>()});
+                    // Empty types are tags: a bit in the entity mask and no storage
+                    if (std::is_empty<T>::value)
+                        tags_.set(type);
 
-                    // Increment the value so that the next component registered will be different
-                    ++next_component_type_;
+                    if (storage_mode_ == ECSStorageMode::ARCHETYPE)
+                    {
+                        // Archetype columns are moved around with memcpy
+                        assert(std::is_trivially_copyable<T>::value && "Archetype components must be trivially copyable.");
+
+                        // Tags still split archetypes, but get a zero-width column
+                        std::uint32_t size = std::is_empty<T>::value ? 0 : sizeof(T);
+                        archetypes_.register_component(type, ECSComponentInfo { size, alignof(T) });
+                    }
+                    else if (!std::is_empty<T>::value)
+                    {
+                        // Create the ComponentArray, indexed by its component type
+                        component_arrays_[type] = std::make_unique<ECSComponentArray<T>>();
+                    }
                 }
 
                 template<typename T>
-                ECSComponentType get_component_type()
+                ECSComponentType get_component_type() const
                 {
-                    const char* type_name = typeid(T).name();
+                    ECSComponentType type = type_id_<T>();
 
-                    assert(component_types_.find(type_name) != component_types_.end() && "Component not registered before use.");
+                    assert(registered_.test(type) && "Component not registered before use.");
 
                     // Return this component's type - used for creating masks
-                    return component_types_[type_name];
+                    return type;
+                }
+
+                // Tags only live in the entity mask, kept by the Coordinator
+                template<typename T>
+                bool is_tag() const
+                {
+                    return tags_.test(get_component_type<T>());
                 }
 
                 template<typename T>
                 void add_component(ECSEntity entity, T component)
                 {
+                    if (storage_mode_ == ECSStorageMode::ARCHETYPE)
+                        return archetypes_.add(entity, get_component_type<T>(), &component);
+
                     // Add a component to the array for an entity
-                    get_component_array_<T>()->insert(entity, component);
+                    if constexpr (!std::is_empty<T>::value)
+                        get_component_array_<T>()->insert(entity, component);
+
+                    ++versions_[get_component_type<T>()];
+                }
+
+                // Gives each of the entities, which must have no component yet, a
+                // copy of every component of the prefab
+                void instantiate(ECSEntity const* entities, std::size_t count, ECSPrefab const& prefab)
+                {
+                    ECSMask mask = prefab.get_mask();
+
+                    assert((mask & ~registered_).none() && "Component not registered before use.");
+
+                    if (storage_mode_ == ECSStorageMode::ARCHETYPE)
+                        archetypes_.insert(entities, count, mask, prefab.get_values());
+
+                    for (ECSComponentType type = 0; type < MAX_COMPONENTS; ++type)
+                    {
+                        if (!mask.test(type))
+                            continue;
+
+                        if (storage_mode_ == ECSStorageMode::SPARSE_SET && !tags_.test(type))
+                            component_arrays_[type]->insert_copies(entities, count, prefab.get_value(type));
+
+                        ++versions_[type];
+                    }
                 }
 
                 template<typename T>
                 void remove_component(ECSEntity entity)
                 {
+                    if (storage_mode_ == ECSStorageMode::ARCHETYPE)
+                        return archetypes_.remove(entity, get_component_type<T>());
+
                     // Remove a component from the array for an entity
-                    get_component_array_<T>()->remove(entity);
+                    if constexpr (!std::is_empty<T>::value)
+                        get_component_array_<T>()->remove(entity);
+
+                    ++versions_[get_component_type<T>()];
                 }
 
                 template<typename T>
                 T& get_component(ECSEntity entity)
                 {
+                    static_assert(!std::is_empty<T>::value, "Tag components have no data.");
+
+                    if (storage_mode_ == ECSStorageMode::ARCHETYPE)
+                        return *static_cast<T*>(archetypes_.get(entity, get_component_type<T>()));
+
                     // Get a reference to a component from the array for an entity
                     return get_component_array_<T>()->get(entity);
                 }
 
-                void entity_destroyed(ECSEntity entity)
+                // Sparse-set storage only: the packed array of a component type
+                template<typename T>
+                ECSComponentArray<T>* get_component_array()
+                {
+                    static_assert(!std::is_empty<T>::value, "Tag components have no storage.");
+                    assert(storage_mode_ == ECSStorageMode::SPARSE_SET && "Component arrays require sparse-set storage.");
+
+                    return get_component_array_<T>();
+                }
+
+                // Sparse-set storage only: exchanges two slots of the packed array of a
+                // component type. The owners stay the same, so only the order version
+                // changes: cached dense indices are stale, cached entity sets are not.
+                template<typename T>
+                void swap_slots(std::uint32_t a, std::uint32_t b)
+                {
+                    get_component_array<T>()->swap_slots(a, b);
+                    ++swap_versions_[get_component_type<T>()];
+                }
+
+                // Sparse-set storage only: replaces the content of the packed array of
+                // a component type (see ECSComponentArray::assign)
+                template<typename T>
+                void assign_component_array(ECSEntity const* entities, void const* components, std::size_t count)
+                {
+                    static_assert(std::is_trivially_copyable<T>::value, "Bulk loaded components must be trivially copyable.");
+
+                    get_component_array<T>()->assign(entities, components, count);
+                    ++versions_[get_component_type<T>()];
+                }
+
+                // Registered types, and the ones among them that are tags
+                ECSMask get_registered_mask() const
                 {
-                    // Notify each component array that an entity has been destroyed
-                    // If it has a component for that entity, it will remove it
-                    for (auto const& pair : component_arrays_)
+                    return registered_;
+                }
+
+                ECSMask get_tag_mask() const
+                {
+                    return tags_;
+                }
+
+                // Bumps the structural version of every type of the mask, e.g. after
+                // the entity masks were replaced as a whole
+                void invalidate(ECSMask types)
+                {
+                    for (ECSComponentType type = 0; type < MAX_COMPONENTS; ++type)
+                        if (types.test(type))
+                            ++versions_[type];
+                }
+
+                // Structural version of a component type, bumped every time the set of
+                // entities owning it changes - used to invalidate cached queries
+                std::uint32_t get_version(ECSComponentType type) const
+                {
+                    return versions_[type];
+                }
+
+                // Changes with the structural version and with every swap of slots -
+                // used to invalidate cached dense indices
+                std::uint32_t get_order_version(ECSComponentType type) const
+                {
+                    return versions_[type] + swap_versions_[type];
+                }
+
+                /// MARK: - Change tracking (sparse-set storage only)
+
+                // Starts recording when components of type T are added or written
+                template<typename T>
+                void enable_change_tracking()
+                {
+                    get_component_array<T>()->enable_change_tracking(&tick_);
+                }
+
+                ECSTick get_tick() const
+                {
+                    return tick_.load(std::memory_order_relaxed);
+                }
+
+                // Moves to the next tick and returns it. Everything changed from now
+                // on is recorded at (or after) the returned tick. Systems running
+                // concurrently may call it.
+                ECSTick advance_tick()
+                {
+                    return tick_.fetch_add(1, std::memory_order_relaxed) + 1;
+                }
+
+                // Records a component fetched with get_component as changed. Does
+                // nothing with archetype storage, which does not track changes.
+                template<typename T>
+                void mark_changed(ECSEntity entity)
+                {
+                    if (storage_mode_ == ECSStorageMode::ARCHETYPE)
+                        return;
+
+                    ECSComponentArray<T>* array = get_component_array<T>();
+
+                    array->mark_changed_at(array->index_of(entity));
+                }
+
+                // Calls fn(entity, T&) for every component of type T added or changed
+                // at or after tick since
+                template<typename T, typename F>
+                void each_changed(ECSTick since, F&& fn)
+                {
+                    get_component_array<T>()->each_changed(since, std::forward<F>(fn));
+                }
+
+                // Archetype storage only: calls fn(count, entities, Ts*...) for every chunk
+                // holding all the given components, with one pointer per component column.
+                template<typename... Ts, typename F>
+                void each_chunk(F&& fn)
+                {
+                    assert(storage_mode_ == ECSStorageMode::ARCHETYPE && "Chunk iteration requires archetype storage.");
+
+                    each_chunk_<Ts...>(fn, std::index_sequence_for<Ts...>{});
+                }
+
+                void entity_destroyed(ECSEntity entity, ECSMask mask)
+                {
+                    if (storage_mode_ == ECSStorageMode::ARCHETYPE)
+                        return archetypes_.entity_destroyed(entity);
+
+                    // Only notify the component arrays selected by the entity's mask,
+                    // tags losing their entity without touching any storage
+                    for (ECSComponentType type = 0; type < MAX_COMPONENTS; ++type)
+                    {
+                        if (!mask.test(type))
+                            continue;
+
+                        if (tags_.test(type) || component_arrays_[type]->entity_destroyed(entity))
+                            ++versions_[type];
+                    }
+                }
+
+                // Destroyed entities, listed once each with their masks: every
+                // component array loses all of its entities of the batch at once
+                void entities_destroyed(ECSEntity const* entities, ECSMask const* masks, std::size_t count)
+                {
+                    if (storage_mode_ == ECSStorageMode::ARCHETYPE)
+                    {
+                        for (std::size_t i = 0; i < count; ++i)
+                            archetypes_.entity_destroyed(entities[i]);
+
+                        return;
+                    }
+
+                    ECSMask types;
+                    for (std::size_t i = 0; i < count; ++i)
+                        types |= masks[i];
+
+                    std::vector<ECSEntity> owners;
+                    for (ECSComponentType type = 0; type < MAX_COMPONENTS; ++type)
                     {
-                        auto const& component = pair.second;
-                        component->entity_destroyed(entity);
+                        if (!types.test(type))
+                            continue;
+
+                        ++versions_[type];
+
+                        if (tags_.test(type))
+                            continue;
+
+                        owners.clear();
+                        for (std::size_t i = 0; i < count; ++i)
+                            if (masks[i].test(type))
+                                owners.push_back(entities[i]);
+
+                        component_arrays_[type]->entities_destroyed(owners.data(), owners.size());
                     }
                 }
 
             private:
-                // Map from type string pointer to a component type
-                std::unordered_map<const char*, ECSComponentType> component_types_{};
+                ECSStorageMode storage_mode_;
+
+                // Component storage used in archetype mode
+                ECSArchetypeStorage archetypes_{};
 
-                // Map from type string pointer to a component array
-                std::unordered_map<const char*, std::shared_ptr<ECSComponentArrayInterface>> component_arrays_{};
+                // Component types registered so far
+                ECSMask registered_{};
 
-                // The component type to be assigned to the next registered component - starting at 0
-                ECSComponentType next_component_type_{};
+                // Registered types with no data
+                ECSMask tags_{};
+
+                // Component arrays, indexed by component type
+                std::array<std::unique_ptr<ECSComponentArrayInterface>, MAX_COMPONENTS> component_arrays_{};
+
+                // Structural version of each component type
+                std::array<std::uint32_t, MAX_COMPONENTS> versions_{};
+
+                // Slot swaps of each component type
+                std::array<std::uint32_t, MAX_COMPONENTS> swap_versions_{};
+
+                // Current change tracking tick, read by the tracked component arrays
+                std::atomic<ECSTick> tick_ = 1;
+
+                template<typename T>
+                static ECSComponentType type_id_()
+                {
+                    std::uint32_t id = ECSTypeId<ECSComponentFamily>::get<T>();
+
+                    assert(id < MAX_COMPONENTS && "Too many component types.");
+
+                    return static_cast<ECSComponentType>(id);
+                }
 
                 // Convenience function to get the statically casted pointer to the ComponentArray of type T.
+                // No hashing and no reference counting: a plain indexed load.
                 template<typename T>
-                std::shared_ptr<ECSComponentArray<T>> get_component_array_()
+                ECSComponentArray<T>* get_component_array_()
                 {
-                    const char* type_name = typeid(T).name();
+                    return static_cast<ECSComponentArray<T>*>(component_arrays_[get_component_type<T>()].get());
+                }
 
-                    assert(component_types_.find(type_name) != component_types_.end() && "Component not registered before use.");
+                template<typename... Ts, typename F, std::size_t... Is>
+                void each_chunk_(F& fn, std::index_sequence<Is...>)
+                {
+                    ECSComponentType types[] = { get_component_type<Ts>()... };
+
+                    ECSMask mask;
+                    for (ECSComponentType type : types)
+                        mask.set(type);
 
-                    return std::static_pointer_cast<ECSComponentArray<T>>(component_arrays_[type_name]);
+                    archetypes_.for_each_chunk(mask, [&](ECSArchetype& archetype, std::size_t chunk)
+                    {
+                        fn(
+                            archetype.chunk_size(chunk),
+                            archetype.entities(chunk),
+                            static_cast<Ts*>(archetype.column(chunk, types[Is]))...
+                        );
+                    });
                 }
         };
     }
@@ -1,6 +1,8 @@
 #pragma once
 
-#include <queue>
+#include <algorithm>
+#include <cassert>
+#include <vector>
 
 #include "ecs_types.hpp"
 
@@ -8,65 +10,194 @@ namespace engine
 {
     namespace ecs
     {
+        // Entity indices are handed out sequentially and recycled through a free
+        // list, so memory grows with the peak number of living entities and nothing
+        // depends on a maximum entity count at construction.
+        // Every index carries a version, bumped when the entity is destroyed, so
+        // handles to destroyed entities can be told apart from living ones.
         class ECSEntityManager
         {
             public:
-                ECSEntityManager()
+                ECSEntity create_entity()
                 {
-                    // Initialize the queue with all possible entity IDs
-                    for (ECSEntity entity = 0; entity < MAX_ENTITIES; ++entity)
-                        unused_entity_queue_.push(entity);
+                    ECSEntity entity;
+                    create_entities(1, &entity);
+
+                    return entity;
                 }
 
-                ECSEntity create_entity()
+                // Creates count entities, writing their handles to out
+                void create_entities(std::size_t count, ECSEntity* out)
                 {
-                    assert(nb_entities_ < MAX_ENTITIES && "Too many entities in existence.");
+                    // Reuse destroyed indices first
+                    std::size_t reused = std::min(count, free_indices_.size());
+                    for (std::size_t i = 0; i < reused; ++i)
+                    {
+                        ECSEntityIndex index = free_indices_.back();
+                        free_indices_.pop_back();
+
+                        out[i] = make_entity(index, versions_[index]);
+                    }
+
+                    // Then grow the arrays in one go for the remaining ones
+                    std::size_t first = versions_.size();
+                    std::size_t added = count - reused;
+
+                    assert(first + added < MAX_ENTITY && "Too many entities in existence.");
+
+                    versions_.resize(first + added, 0);
+                    entity_masks_.resize(first + added);
 
-                    // Take an ID from the front of the queue
-                    ECSEntity id = unused_entity_queue_.front();
-                    unused_entity_queue_.pop();
-                    ++nb_entities_;
+                    for (std::size_t i = 0; i < added; ++i)
+                        out[reused + i] = make_entity(static_cast<ECSEntityIndex>(first + i), 0);
 
-                    return id;
+                    nb_entities_ += static_cast<std::uint32_t>(count);
                 }
 
                 void destroy_entity(ECSEntity entity)
                 {
-                    assert(entity < MAX_ENTITIES && "Entity out of range.");
+                    assert(is_alive(entity) && "Destroying a dead entity.");
 
-                    // Invalidate the destroyed entity's mask
-                    entity_masks_[entity].reset();
+                    ECSEntityIndex index = entity_index(entity);
 
-                    // Put the destroyed ID at the back of the queue
-                    unused_entity_queue_.push(entity);
+                    // Invalidate the destroyed entity's mask and outstanding handles
+                    // The all-ones version is reserved for provisional handles
+                    entity_masks_[index].reset();
+                    if (++versions_[index] == ~ECSEntityVersion(0))
+                        versions_[index] = 0;
+
+                    // Put the destroyed index in the free list
+                    free_indices_.push_back(index);
                     --nb_entities_;
                 }
 
+                // Destroys the living entities among count handles, each once,
+                // writing their handles and masks to out and out_masks. Returns how
+                // many were destroyed; their indices join the free list together.
+                std::size_t destroy_entities(ECSEntity const* entities, std::size_t count, ECSEntity* out, ECSMask* out_masks)
+                {
+                    std::size_t destroyed = 0;
+
+                    for (std::size_t i = 0; i < count; ++i)
+                    {
+                        // Bumped versions leave the handles listed again dead
+                        if (!is_alive(entities[i]))
+                            continue;
+
+                        ECSEntityIndex index = entity_index(entities[i]);
+
+                        out[destroyed] = entities[i];
+                        out_masks[destroyed] = entity_masks_[index];
+                        ++destroyed;
+
+                        entity_masks_[index].reset();
+                        if (++versions_[index] == ~ECSEntityVersion(0))
+                            versions_[index] = 0;
+                    }
+
+                    std::size_t first = free_indices_.size();
+                    free_indices_.resize(first + destroyed);
+                    for (std::size_t i = 0; i < destroyed; ++i)
+                        free_indices_[first + i] = entity_index(out[i]);
+
+                    nb_entities_ -= static_cast<std::uint32_t>(destroyed);
+
+                    return destroyed;
+                }
+
+                bool is_alive(ECSEntity entity) const
+                {
+                    ECSEntityIndex index = entity_index(entity);
+
+                    return index < versions_.size() && versions_[index] == entity_version(entity);
+                }
+
                 void set_mask(ECSEntity entity, ECSMask mask)
                 {
-                    assert(entity < MAX_ENTITIES && "Entity out of range.");
+                    assert(is_alive(entity) && "Entity is not alive.");
 
                     // Put this entity's mask into the array
-                    entity_masks_[entity] = mask;
+                    entity_masks_[entity_index(entity)] = mask;
                 }
 
-                ECSMask get_mask(ECSEntity entity)
+                ECSMask get_mask(ECSEntity entity) const
                 {
-                    assert(entity < MAX_ENTITIES && "Entity out of range.");
+                    assert(is_alive(entity) && "Entity is not alive.");
 
                     // Get this entity's mask from the array
-                    return entity_masks_[entity];
+                    return entity_masks_[entity_index(entity)];
+                }
+
+                // Pre-allocates room for a number of entities
+                void reserve(std::size_t capacity)
+                {
+                    versions_.reserve(capacity);
+                    entity_masks_.reserve(capacity);
+                }
+
+                std::uint32_t get_entity_count() const
+                {
+                    return nb_entities_;
+                }
+
+                // Calls fn(entity) for every living entity, in index order
+                template<typename F>
+                void each_entity(F&& fn) const
+                {
+                    std::vector<bool> free(versions_.size(), false);
+                    for (ECSEntityIndex index : free_indices_)
+                        free[index] = true;
+
+                    for (std::size_t index = 0; index < versions_.size(); ++index)
+                        if (!free[index])
+                            fn(make_entity(static_cast<ECSEntityIndex>(index), versions_[index]));
+                }
+
+                /// MARK: - Bulk state access, for snapshots
+
+                std::vector<ECSEntityVersion> const& get_versions() const
+                {
+                    return versions_;
+                }
+
+                std::vector<ECSMask> const& get_masks() const
+                {
+                    return entity_masks_;
+                }
+
+                std::vector<ECSEntityIndex> const& get_free_indices() const
+                {
+                    return free_indices_;
+                }
+
+                // Replaces the whole state: versions and masks of every index (masks
+                // stored as the bits of a 32-bit integer) and the free list
+                void restore(ECSEntityVersion const* versions, std::uint32_t const* masks, std::size_t count, ECSEntityIndex const* free_indices, std::size_t free_count)
+                {
+                    static_assert(MAX_COMPONENTS <= 32, "Entity masks are stored as 32-bit integers.");
+
+                    versions_.assign(versions, versions + count);
+                    free_indices_.assign(free_indices, free_indices + free_count);
+
+                    entity_masks_.resize(count);
+                    for (std::size_t index = 0; index < count; ++index)
+                        entity_masks_[index] = ECSMask(masks[index]);
+
+                    nb_entities_ = static_cast<std::uint32_t>(count - free_count);
                 }
 
             private:
-                // Queue of unused entity IDs
-                std::queue<ECSEntity> unused_entity_queue_{};
+                // Stack of destroyed entity indices available for reuse
+                std::vector<ECSEntityIndex> free_indices_{};
+
+                // Current version of every index
+                std::vector<ECSEntityVersion> versions_{};
 
-                // Array of masks where the index corresponds to the entity ID
-                std::array<ECSMask, MAX_ENTITIES> entity_masks_{};
+                // Array of masks where the index corresponds to the entity index
+                std::vector<ECSMask> entity_masks_{};
 
-                // Total living entities - used to keep limits on how many exist
-                uint32_t nb_entities_{};
+                // Total living entities
+                std::uint32_t nb_entities_{};
         };
     }
 }
\ No newline at end of file
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <functional>
+#include <vector>
+
+#include "ecs_types.hpp"
+#include "ecs_type_id.hpp"
+#include "ecs_component_manager.hpp"
+#include "ecs_entity_manager.hpp"
+
+namespace engine
+{
+    namespace ecs
+    {
+        enum class ECSObserverEvent : std::uint8_t
+        {
+            ADD,
+            REMOVE,
+            CHANGE,
+            COUNT
+        };
+
+        // Called with every entity a component event happened to since the last
+        // dispatch, in one contiguous batch - expensive work can be spread over
+        // a job system from there.
+        using ECSObserver = std::function<void(ECSEntity const* entities, std::size_t count)>;
+
+        // Per component type observers of additions, removals and changes.
+        // Structural changes are only recorded when they happen (one push_back,
+        // and only for observed types and events); observers are called later,
+        // in batches, by dispatch. Changes come from change tracking, which
+        // observing them enables for the type.
+        class ECSObserverManager
+        {
+            public:
+                template<typename T>
+                void add_observer(ECSObserverEvent event, ECSComponentManager& component_manager, ECSObserver observer)
+                {
+                    ECSComponentType type = component_manager.get_component_type<T>();
+                    Observed& observed = observed_[index_(event, type)];
+
+                    if (event == ECSObserverEvent::CHANGE && !observed.collect)
+                    {
+                        if constexpr (std::is_empty<T>::value)
+                        {
+                            assert(false && "Tag components never change.");
+                        }
+                        else
+                        {
+                            // Components existing before count as changed at the current
+                            // tick: only report what happens from the next one on
+                            component_manager.enable_change_tracking<T>();
+                            observed.since = component_manager.advance_tick();
+
+                            observed.collect = [](ECSComponentManager& manager, ECSTick since, std::vector<ECSEntity>& out)
+                            {
+                                manager.each_changed<T>(since, [&](ECSEntity entity, T&)
+                                {
+                                    out.push_back(entity);
+                                });
+                            };
+                        }
+                    }
+
+                    observed.observers.push_back(std::move(observer));
+                    masks_[static_cast<std::size_t>(event)].set(type);
+                }
+
+                bool is_observed(ECSObserverEvent event, ECSComponentType type) const
+                {
+                    return masks_[static_cast<std::size_t>(event)].test(type);
+                }
+
+                // Records the components of mask (observed ones only) as added or removed
+                void record(ECSObserverEvent event, ECSEntity entity, ECSMask mask)
+                {
+                    assert(event != ECSObserverEvent::CHANGE && "Changes are collected from change tracking.");
+
+                    mask &= masks_[static_cast<std::size_t>(event)];
+                    if (mask.none())
+                        return;
+
+                    for (ECSComponentType type = 0; type < MAX_COMPONENTS; ++type)
+                        if (mask.test(type))
+                            observed_[index_(event, type)].pending.push_back(entity);
+                }
+
+                // Same as record, for entities sharing the same mask
+                void record(ECSObserverEvent event, ECSEntity const* entities, std::size_t count, ECSMask mask)
+                {
+                    assert(event != ECSObserverEvent::CHANGE && "Changes are collected from change tracking.");
+
+                    mask &= masks_[static_cast<std::size_t>(event)];
+                    if (mask.none())
+                        return;
+
+                    for (ECSComponentType type = 0; type < MAX_COMPONENTS; ++type)
+                    {
+                        if (mask.test(type))
+                        {
+                            auto& pending = observed_[index_(event, type)].pending;
+                            pending.insert(pending.end(), entities, entities + count);
+                        }
+                    }
+                }
+
+                // Calls the observers with everything recorded since the last dispatch.
+                // Additions and changes only report the entities still owning the
+                // component; removals report every entity, including destroyed ones.
+                // Observers may change the world: what they do is recorded for the
+                // next dispatch.
+                void dispatch(ECSComponentManager& component_manager, ECSEntityManager const& entity_manager)
+                {
+                    // Gather every batch before calling anyone, so nothing an observer
+                    // does can end up in a batch of this dispatch
+                    ECSTick now = component_manager.advance_tick();
+
+                    for (std::size_t i = 0; i < observed_.size(); ++i)
+                    {
+                        Observed& observed = observed_[i];
+
+                        if (observed.observers.empty())
+                            continue;
+
+                        auto event = static_cast<ECSObserverEvent>(i / MAX_COMPONENTS);
+                        auto type = static_cast<ECSComponentType>(i % MAX_COMPONENTS);
+
+                        observed.batch.clear();
+
+                        if (event == ECSObserverEvent::CHANGE)
+                        {
+                            observed.collect(component_manager, observed.since, observed.batch);
+                            observed.since = now;
+                        }
+                        else
+                        {
+                            observed.batch.swap(observed.pending);
+                        }
+
+                        if (event == ECSObserverEvent::ADD)
+                        {
+                            observed.batch.erase(std::remove_if(observed.batch.begin(), observed.batch.end(), [&](ECSEntity entity)
+                            {
+                                return !entity_manager.is_alive(entity) || !entity_manager.get_mask(entity).test(type);
+                            }), observed.batch.end());
+                        }
+                    }
+
+                    for (auto& observed : observed_)
+                    {
+                        if (observed.batch.empty())
+                            continue;
+
+                        for (auto const& observer : observed.observers)
+                            observer(observed.batch.data(), observed.batch.size());
+                    }
+                }
+
+            private:
+                using Collect = void (*)(ECSComponentManager&, ECSTick, std::vector<ECSEntity>&);
+
+                struct Observed
+                {
+                    std::vector<ECSObserver> observers{};
+
+                    // Entities recorded since the last dispatch (add/remove)
+                    std::vector<ECSEntity> pending{};
+
+                    // Entities being delivered
+                    std::vector<ECSEntity> batch{};
+
+                    // Gathers the changed entities of the type, and the tick it
+                    // starts from (change)
+                    Collect collect = nullptr;
+                    ECSTick since = 0;
+                };
+
+                static std::size_t index_(ECSObserverEvent event, ECSComponentType type)
+                {
+                    return static_cast<std::size_t>(event) * MAX_COMPONENTS + type;
+                }
+
+                // Observed component types, per event
+                std::array<ECSMask, static_cast<std::size_t>(ECSObserverEvent::COUNT)> masks_{};
+
+                // Indexed by event, then component type
+                std::array<Observed, static_cast<std::size_t>(ECSObserverEvent::COUNT) * MAX_COMPONENTS> observed_{};
+        };
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "ecs_types.hpp"
+#include "ecs_type_id.hpp"
+
+namespace engine
+{
+    namespace ecs
+    {
+        // A set of components with default values, to spawn many identical
+        // entities at once with Coordinator::instantiate.
+        // The mask and the values are computed once, when building the prefab;
+        // instantiating copies them into the storage in bulk instead of going
+        // through add_component for every component of every entity.
+        // Like command buffers, prefabs do not depend on a world.
+        class ECSPrefab
+        {
+            public:
+                // Adds a component to the prefab, or replaces its value.
+                // Tags (empty types) are added without a value: set<Tag>()
+                template<typename T>
+                ECSPrefab& set(T component = {})
+                {
+                    // Component values are copied into a byte arena
+                    static_assert(std::is_trivially_copyable<T>::value, "Prefab components must be trivially copyable.");
+                    static_assert(alignof(T) <= alignof(std::max_align_t), "Prefab components must not be over-aligned.");
+
+                    ECSComponentType type = component_type_<T>();
+
+                    if constexpr (!std::is_empty<T>::value)
+                    {
+                        if (!mask_.test(type))
+                        {
+                            std::size_t offset = (values_.size() + alignof(T) - 1) / alignof(T) * alignof(T);
+                            values_.resize(offset + sizeof(T));
+                            offsets_[type] = static_cast<std::uint32_t>(offset);
+                        }
+
+                        std::memcpy(values_.data() + offsets_[type], &component, sizeof(T));
+                    }
+
+                    mask_.set(type);
+
+                    return *this;
+                }
+
+                template<typename T>
+                bool has() const
+                {
+                    return mask_.test(component_type_<T>());
+                }
+
+                ECSMask get_mask() const
+                {
+                    return mask_;
+                }
+
+                // Value of a component type of the prefab, null for tags
+                void const* get_value(ECSComponentType type) const
+                {
+                    assert(mask_.test(type) && "Component type not part of the prefab.");
+
+                    return offsets_[type] == NO_VALUE ? nullptr : values_.data() + offsets_[type];
+                }
+
+                // Values of all the component types, indexed by type
+                std::array<void const*, MAX_COMPONENTS> get_values() const
+                {
+                    std::array<void const*, MAX_COMPONENTS> values{};
+                    for (ECSComponentType type = 0; type < MAX_COMPONENTS; ++type)
+                        if (mask_.test(type))
+                            values[type] = get_value(type);
+
+                    return values;
+                }
+
+            private:
+                static constexpr std::uint32_t NO_VALUE = ~std::uint32_t(0);
+
+                template<typename T>
+                static ECSComponentType component_type_()
+                {
+                    std::uint32_t id = ECSTypeId<ECSComponentFamily>::get<T>();
+
+                    assert(id < MAX_COMPONENTS && "Too many component types.");
+
+                    return static_cast<ECSComponentType>(id);
+                }
+
+                ECSMask mask_{};
+
+                // Offset of every component value in the arena, indexed by type
+                std::array<std::uint32_t, MAX_COMPONENTS> offsets_ = make_offsets_();
+
+                // Arena holding the component values. Heap blocks are aligned for
+                // any type that is not over-aligned, and so are the values.
+                std::vector<std::byte> values_{};
+
+                static std::array<std::uint32_t, MAX_COMPONENTS> make_offsets_()
+                {
+                    std::array<std::uint32_t, MAX_COMPONENTS> offsets;
+                    offsets.fill(NO_VALUE);
+
+                    return offsets;
+                }
+        };
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cassert>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "ecs_type_id.hpp"
+
+namespace engine
+{
+    namespace ecs
+    {
+        // Typed singletons (input state, active camera, ...) stored once per world
+        // instead of in an entity or ad hoc in a system.
+        // Resources are indexed by a dense type ID, so getting one is a plain
+        // indexed load.
+        class ECSResourceManager
+        {
+            public:
+                // Stores a resource, replacing the previous one of the same type
+                template<typename T>
+                T& set_resource(T resource)
+                {
+                    std::uint32_t type = ECSTypeId<ECSResourceFamily>::get<T>();
+
+                    if (type >= resources_.size())
+                        resources_.resize(type + 1);
+
+                    resources_[type] = std::make_shared<T>(std::move(resource));
+
+                    return *static_cast<T*>(resources_[type].get());
+                }
+
+                template<typename T>
+                T& get_resource()
+                {
+                    assert(has_resource<T>() && "Retrieving non-existent resource.");
+
+                    return *static_cast<T*>(resources_[ECSTypeId<ECSResourceFamily>::get<T>()].get());
+                }
+
+                template<typename T>
+                bool has_resource() const
+                {
+                    std::uint32_t type = ECSTypeId<ECSResourceFamily>::get<T>();
+
+                    return type < resources_.size() && resources_[type];
+                }
+
+                template<typename T>
+                void remove_resource()
+                {
+                    assert(has_resource<T>() && "Removing non-existent resource.");
+
+                    resources_[ECSTypeId<ECSResourceFamily>::get<T>()].reset();
+                }
+
+            private:
+                // Resources indexed by resource type ID - shared_ptr<void> keeps
+                // the right deleter for each of them
+                std::vector<std::shared_ptr<void>> resources_{};
+        };
+    }
+}
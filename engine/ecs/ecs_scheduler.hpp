@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "ecs_types.hpp"
+#include "ecs_system.hpp"
+
+#include "utils_job_system.hpp"
+
+namespace engine
+{
+    namespace ecs
+    {
+        // Runs systems concurrently on a job system, based on the component types
+        // each of them declared to read and write.
+        // Every frame a dependency graph is built from the registration order:
+        // a system runs after every earlier system it conflicts with (write-write,
+        // read-write or write-read on a component type), and non-conflicting
+        // systems run in parallel.
+        class ECSScheduler
+        {
+            public:
+                void add(std::shared_ptr<ECSSystem> system, std::string name)
+                {
+                    nodes_.push_back({ std::move(system), std::move(name) });
+                }
+
+                void run(utils::JobSystem& job_system, float dt)
+                {
+                    build_();
+
+                    // One counter per system holding its unfinished predecessors
+                    std::vector<std::unique_ptr<utils::JobCounter>> pending;
+                    for (auto const& node : nodes_)
+                        pending.push_back(std::make_unique<utils::JobCounter>(static_cast<int>(node.predecessors.size())));
+
+                    utils::JobCounter frame;
+
+                    for (std::size_t i = 0; i < nodes_.size(); ++i)
+                    {
+                        job_system.schedule([this, &job_system, &pending, i, dt]()
+                        {
+                            Node& node = nodes_[i];
+
+                            auto start = std::chrono::steady_clock::now();
+                            node.system->update(dt);
+                            node.duration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+                            // Release the systems waiting on this one
+                            for (std::size_t successor : node.successors)
+                                job_system.decrement(*pending[successor]);
+                        }, &frame, pending[i].get());
+                    }
+
+                    job_system.wait(frame);
+                }
+
+                // Writes the schedule of the last frame: the level of every system
+                // (systems of the same level may run concurrently), what it waits
+                // for, and how long its update took.
+                void dump(std::ostream& stream) const
+                {
+                    stream << "System schedule (" << nodes_.size() << " systems)\n";
+
+                    for (auto const& node : nodes_)
+                    {
+                        stream << "  [" << node.level << "] " << std::left << std::setw(24) << node.name
+                               << " reads " << node.system->get_reads()
+                               << " writes " << node.system->get_writes()
+                               << " " << std::fixed << std::setprecision(3) << node.duration << "ms";
+
+                        if (!node.predecessors.empty())
+                        {
+                            stream << " after";
+                            for (std::size_t predecessor : node.predecessors)
+                                stream << " " << nodes_[predecessor].name;
+                        }
+
+                        stream << "\n";
+                    }
+                }
+
+            private:
+                struct Node
+                {
+                    std::shared_ptr<ECSSystem> system;
+                    std::string name;
+
+                    std::vector<std::size_t> predecessors{};
+                    std::vector<std::size_t> successors{};
+
+                    // Longest chain of predecessors
+                    std::size_t level = 0;
+
+                    // Duration of the last update, in milliseconds
+                    double duration = 0;
+                };
+
+                static bool conflict_(ECSSystem const& first, ECSSystem const& second)
+                {
+                    return (first.get_writes() & (second.get_reads() | second.get_writes())).any()
+                        || (first.get_reads() & second.get_writes()).any();
+                }
+
+                void build_()
+                {
+                    for (std::size_t j = 0; j < nodes_.size(); ++j)
+                    {
+                        Node& node = nodes_[j];
+
+                        node.predecessors.clear();
+                        node.successors.clear();
+                        node.level = 0;
+
+                        for (std::size_t i = 0; i < j; ++i)
+                        {
+                            if (!conflict_(*nodes_[i].system, *node.system))
+                                continue;
+
+                            node.predecessors.push_back(i);
+                            nodes_[i].successors.push_back(j);
+                            node.level = std::max(node.level, nodes_[i].level + 1);
+                        }
+                    }
+                }
+
+                std::vector<Node> nodes_{};
+        };
+    }
+}
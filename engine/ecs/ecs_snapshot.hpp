@@ -0,0 +1,439 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "ecs_types.hpp"
+#include "ecs_component_manager.hpp"
+#include "ecs_entity_manager.hpp"
+
+namespace engine
+{
+    namespace ecs
+    {
+        // Binary world snapshots.
+        // A snapshot is a header followed by blobs, each starting on a 64-byte
+        // boundary: the entity versions, masks and free list, the hash of the
+        // type behind every mask bit, a table describing every component array,
+        // then every component array as its packed entities and its packed
+        // components. Loading is a handful of bulk copies plus a rebuild of the
+        // sparse indices - no per-component parsing.
+        //
+        // Component types, tags included, are identified by a hash given when
+        // adding them (e.g. "Transform"_hash). The masks are written with the type
+        // IDs of the saving process and translated to the IDs of the loading one,
+        // so snapshots survive type IDs being handed out in a different order.
+        class ECSSnapshot
+        {
+            public:
+                static constexpr char MAGIC[8] = { 'E', 'C', 'S', 'S', 'N', 'A', 'P', '\0' };
+                static constexpr std::uint32_t FORMAT_VERSION = 2;
+                static constexpr std::size_t ALIGNMENT = 64;
+
+                // Adds a component type to the snapshots. Every registered component
+                // type must be added, tags included.
+                template<typename T>
+                void add(std::uint32_t hash)
+                {
+                    // Tags have no section: only their mask bit is saved
+                    if constexpr (std::is_empty<T>::value)
+                    {
+                        tags_.push_back({
+                            hash,
+                            [](ECSComponentManager& manager)
+                            {
+                                return manager.get_component_type<T>();
+                            }
+                        });
+                    }
+                    else
+                    {
+                        static_assert(std::is_trivially_copyable<T>::value, "Snapshot components must be trivially copyable.");
+
+                        types_.push_back({
+                            hash,
+                            sizeof(T),
+                            [](ECSComponentManager& manager)
+                            {
+                                return manager.get_component_type<T>();
+                            },
+                            [](ECSComponentManager& manager, Blob& blob)
+                            {
+                                ECSComponentArray<T>* array = manager.get_component_array<T>();
+
+                                blob.entities = array->entities();
+                                blob.components = array->components();
+                                blob.count = array->size();
+                            },
+                            [](ECSComponentManager& manager, Blob const& blob)
+                            {
+                                manager.assign_component_array<T>(blob.entities, blob.components, blob.count);
+                            }
+                        });
+                    }
+                }
+
+                // Appends a snapshot of the world to out
+                void write(ECSEntityManager const& entity_manager, ECSComponentManager& component_manager, std::vector<std::byte>& out) const
+                {
+                    assert(covers_(component_manager) && "Component type missing from snapshot.");
+
+                    std::size_t start = out.size();
+                    append_(out, start, nullptr, sizeof(Header));
+
+                    auto const& versions = entity_manager.get_versions();
+                    auto const& masks = entity_manager.get_masks();
+                    auto const& free_indices = entity_manager.get_free_indices();
+
+                    std::vector<std::uint32_t> mask_bits(masks.size());
+                    for (std::size_t i = 0; i < masks.size(); ++i)
+                        mask_bits[i] = static_cast<std::uint32_t>(masks[i].to_ulong());
+
+                    Header header{};
+                    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+                    header.format_version = FORMAT_VERSION;
+                    header.entity_slots = static_cast<std::uint32_t>(versions.size());
+                    header.free_count = static_cast<std::uint32_t>(free_indices.size());
+                    header.section_count = static_cast<std::uint32_t>(types_.size());
+                    header.versions = append_(out, start, versions.data(), versions.size() * sizeof(ECSEntityVersion));
+                    header.masks = append_(out, start, mask_bits.data(), mask_bits.size() * sizeof(std::uint32_t));
+                    header.free_indices = append_(out, start, free_indices.data(), free_indices.size() * sizeof(ECSEntityIndex));
+
+                    // The hash of the type behind each mask bit
+                    std::array<std::uint32_t, MAX_COMPONENTS> type_hashes{};
+                    for (auto const& type : types_)
+                        type_hashes[type.type(component_manager)] = type.hash;
+                    for (auto const& tag : tags_)
+                        type_hashes[tag.type(component_manager)] = tag.hash;
+
+                    header.type_bits = static_cast<std::uint32_t>(component_manager.get_registered_mask().to_ulong());
+                    header.types = append_(out, start, type_hashes.data(), sizeof(type_hashes));
+
+                    // Reserve the section table, filled once the blobs are placed
+                    std::vector<Section> sections(types_.size());
+                    header.sections = append_(out, start, nullptr, sections.size() * sizeof(Section));
+
+                    for (std::size_t i = 0; i < types_.size(); ++i)
+                    {
+                        Blob blob;
+                        types_[i].save(component_manager, blob);
+
+                        sections[i].hash = types_[i].hash;
+                        sections[i].component_size = types_[i].size;
+                        sections[i].count = static_cast<std::uint32_t>(blob.count);
+                        sections[i].entities = append_(out, start, blob.entities, blob.count * sizeof(ECSEntity));
+                        sections[i].components = append_(out, start, blob.components, blob.count * types_[i].size);
+                    }
+
+                    std::memcpy(out.data() + start, &header, sizeof(Header));
+                    if (!sections.empty())
+                        std::memcpy(out.data() + start + header.sections, sections.data(), sections.size() * sizeof(Section));
+                }
+
+                // Replaces the world with a snapshot. Returns false, leaving the world
+                // untouched, if the data is not a valid snapshot for these component types.
+                // The data must be aligned like an entity handle (a mapped file or a
+                // heap buffer is). The caller is responsible for updating the system
+                // entity lists.
+                bool read(std::byte const* data, std::size_t size, ECSEntityManager& entity_manager, ECSComponentManager& component_manager) const
+                {
+                    assert(covers_(component_manager) && "Component type missing from snapshot.");
+                    assert(reinterpret_cast<std::uintptr_t>(data) % alignof(ECSEntity) == 0 && "Snapshot data is misaligned.");
+
+                    Header header;
+                    if (size < sizeof(Header))
+                        return false;
+
+                    std::memcpy(&header, data, sizeof(Header));
+
+                    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.format_version != FORMAT_VERSION)
+                        return false;
+
+                    // Blobs are read in place, so they must sit where write put them
+                    if (header.versions % ALIGNMENT != 0 || header.masks % ALIGNMENT != 0 || header.free_indices % ALIGNMENT != 0
+                        || header.types % ALIGNMENT != 0 || header.sections % ALIGNMENT != 0)
+                        return false;
+
+                    if (header.free_count > header.entity_slots || header.section_count != types_.size()
+                        || !fits_(header.versions, header.entity_slots * sizeof(ECSEntityVersion), size)
+                        || !fits_(header.masks, header.entity_slots * sizeof(std::uint32_t), size)
+                        || !fits_(header.free_indices, header.free_count * sizeof(ECSEntityIndex), size)
+                        || !fits_(header.types, MAX_COMPONENTS * sizeof(std::uint32_t), size)
+                        || !fits_(header.sections, header.section_count * sizeof(Section), size))
+                        return false;
+
+                    ECSEntityVersion const* versions = reinterpret_cast<ECSEntityVersion const*>(data + header.versions);
+                    std::uint32_t const* saved_masks = reinterpret_cast<std::uint32_t const*>(data + header.masks);
+                    ECSEntityIndex const* free_indices = reinterpret_cast<ECSEntityIndex const*>(data + header.free_indices);
+
+                    // Match every saved mask bit with a type of this process
+                    Remap remap;
+                    if (!remap_(reinterpret_cast<std::uint32_t const*>(data + header.types), header.type_bits, component_manager, remap))
+                        return false;
+
+                    // Masks only hold bits of known types. Translated unless the IDs
+                    // are the same as when saving - always the case for in-process states.
+                    std::vector<std::uint32_t> remapped_masks;
+                    std::uint32_t const* masks = saved_masks;
+
+                    if (!remap.identity)
+                    {
+                        remapped_masks.resize(header.entity_slots);
+                        masks = remapped_masks.data();
+                    }
+
+                    for (std::uint32_t index = 0; index < header.entity_slots; ++index)
+                    {
+                        std::uint32_t mask = saved_masks[index];
+
+                        if (mask & ~header.type_bits)
+                            return false;
+
+                        if (!remap.identity)
+                            remapped_masks[index] = remap.bytes[0][mask & 0xFF] | remap.bytes[1][(mask >> 8) & 0xFF]
+                                | remap.bytes[2][(mask >> 16) & 0xFF] | remap.bytes[3][mask >> 24];
+                    }
+
+                    // Every index is free at most once, with an empty mask
+                    std::vector<bool> is_free(header.entity_slots, false);
+                    for (std::uint32_t i = 0; i < header.free_count; ++i)
+                    {
+                        if (free_indices[i] >= header.entity_slots || is_free[free_indices[i]] || masks[free_indices[i]] != 0)
+                            return false;
+
+                        is_free[free_indices[i]] = true;
+                    }
+
+                    // Match every section with a component type before changing anything
+                    std::vector<Section> sections(header.section_count);
+                    if (!sections.empty())
+                        std::memcpy(sections.data(), data + header.sections, sections.size() * sizeof(Section));
+
+                    std::vector<Type const*> section_types(sections.size(), nullptr);
+                    for (std::size_t i = 0; i < sections.size(); ++i)
+                    {
+                        Section const& section = sections[i];
+
+                        for (std::size_t j = 0; j < i; ++j)
+                            if (sections[j].hash == section.hash)
+                                return false;
+
+                        for (auto const& type : types_)
+                            if (type.hash == section.hash && type.size == section.component_size)
+                                section_types[i] = &type;
+
+                        if (!section_types[i]
+                            || section.entities % ALIGNMENT != 0
+                            || section.components % ALIGNMENT != 0
+                            || !fits_(section.entities, std::uint64_t(section.count) * sizeof(ECSEntity), size)
+                            || !fits_(section.components, std::uint64_t(section.count) * section.component_size, size))
+                            return false;
+                    }
+
+                    if (!owners_match_(sections, section_types, data, header, versions, masks, component_manager))
+                        return false;
+
+                    entity_manager.restore(versions, masks, header.entity_slots, free_indices, header.free_count);
+
+                    for (std::size_t i = 0; i < sections.size(); ++i)
+                    {
+                        Blob blob;
+                        blob.entities = reinterpret_cast<ECSEntity const*>(data + sections[i].entities);
+                        blob.components = data + sections[i].components;
+                        blob.count = sections[i].count;
+
+                        section_types[i]->load(component_manager, blob);
+                    }
+
+                    // Tags changed along with the masks
+                    component_manager.invalidate(component_manager.get_tag_mask());
+
+                    return true;
+                }
+
+            private:
+                struct Header
+                {
+                    char magic[8];
+                    std::uint32_t format_version;
+                    std::uint32_t entity_slots;
+                    std::uint32_t free_count;
+                    std::uint32_t section_count;
+                    // Mask bits used when saving, each with its hash in the type table
+                    std::uint32_t type_bits;
+                    std::uint32_t padding;
+
+                    // Offsets of the blobs from the start of the snapshot
+                    std::uint64_t versions;
+                    std::uint64_t masks;
+                    std::uint64_t free_indices;
+                    std::uint64_t types;
+                    std::uint64_t sections;
+                };
+
+                struct Section
+                {
+                    std::uint32_t hash;
+                    std::uint32_t component_size;
+                    std::uint32_t count;
+                    std::uint32_t padding;
+
+                    std::uint64_t entities;
+                    std::uint64_t components;
+                };
+
+                struct Blob
+                {
+                    ECSEntity const* entities = nullptr;
+                    void const* components = nullptr;
+                    std::size_t count = 0;
+                };
+
+                struct Type
+                {
+                    std::uint32_t hash;
+                    std::uint32_t size;
+                    ECSComponentType (*type)(ECSComponentManager&);
+                    void (*save)(ECSComponentManager&, Blob&);
+                    void (*load)(ECSComponentManager&, Blob const&);
+                };
+
+                struct Tag
+                {
+                    std::uint32_t hash;
+                    ECSComponentType (*type)(ECSComponentManager&);
+                };
+
+                // Saved mask bits to the bits of this process, one byte of the mask
+                // at a time: a mask translates with four lookups
+                struct Remap
+                {
+                    std::array<std::array<std::uint32_t, 256>, 4> bytes{};
+                    bool identity = true;
+                };
+
+                // Appends size bytes (zeros if data is null) on an aligned offset
+                // and returns that offset, relative to start
+                static std::uint64_t append_(std::vector<std::byte>& out, std::size_t start, void const* data, std::size_t size)
+                {
+                    std::size_t offset = (out.size() - start + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+                    out.resize(start + offset + size);
+                    if (data && size > 0)
+                        std::memcpy(out.data() + start + offset, data, size);
+
+                    return offset;
+                }
+
+                static bool fits_(std::uint64_t offset, std::uint64_t size, std::size_t total)
+                {
+                    return offset <= total && size <= total - offset;
+                }
+
+                // Builds the translation of the saved mask bits, each of which must
+                // name a different type of this snapshot
+                bool remap_(std::uint32_t const* type_hashes, std::uint32_t type_bits, ECSComponentManager& component_manager, Remap& remap) const
+                {
+                    std::array<std::uint32_t, MAX_COMPONENTS> bits{};
+                    std::uint32_t mapped = 0;
+
+                    for (ECSComponentType saved = 0; saved < MAX_COMPONENTS; ++saved)
+                    {
+                        if (!((type_bits >> saved) & 1))
+                            continue;
+
+                        // MAX_COMPONENTS if the hash is unknown
+                        ECSComponentType type = MAX_COMPONENTS;
+
+                        for (auto const& data_type : types_)
+                            if (data_type.hash == type_hashes[saved])
+                                type = data_type.type(component_manager);
+
+                        for (auto const& tag : tags_)
+                            if (tag.hash == type_hashes[saved])
+                                type = tag.type(component_manager);
+
+                        if (type == MAX_COMPONENTS || ((mapped >> type) & 1))
+                            return false;
+
+                        mapped |= 1u << type;
+                        bits[saved] = 1u << type;
+                        remap.identity = remap.identity && type == saved;
+                    }
+
+                    for (std::uint32_t byte = 0; byte < 4; ++byte)
+                        for (std::uint32_t value = 0; value < 256; ++value)
+                            for (std::uint32_t bit = 0; bit < 8; ++bit)
+                                if ((value >> bit) & 1)
+                                    remap.bytes[byte][value] |= bits[byte * 8 + bit];
+
+                    return true;
+                }
+
+                // Whether the entities of every section are exactly the living
+                // entities whose mask holds its type, each listed once. One pass
+                // over each section, then one over the masks for all of them.
+                static bool owners_match_(
+                    std::vector<Section> const& sections,
+                    std::vector<Type const*> const& section_types,
+                    std::byte const* data,
+                    Header const& header,
+                    ECSEntityVersion const* versions,
+                    std::uint32_t const* masks,
+                    ECSComponentManager& component_manager
+                )
+                {
+                    // Bits of the sections listing each index
+                    std::vector<std::uint32_t> listed(header.entity_slots, 0);
+                    std::uint32_t stored = 0;
+
+                    for (std::size_t i = 0; i < sections.size(); ++i)
+                    {
+                        ECSEntity const* entities = reinterpret_cast<ECSEntity const*>(data + sections[i].entities);
+                        std::uint32_t bit = 1u << section_types[i]->type(component_manager);
+
+                        for (std::uint32_t j = 0; j < sections[i].count; ++j)
+                        {
+                            ECSEntityIndex index = entity_index(entities[j]);
+
+                            if (index >= header.entity_slots || (listed[index] & bit)
+                                || versions[index] != entity_version(entities[j])
+                                || !(masks[index] & bit))
+                                return false;
+
+                            listed[index] |= bit;
+                        }
+
+                        stored |= bit;
+                    }
+
+                    // No owner left out
+                    for (std::uint32_t index = 0; index < header.entity_slots; ++index)
+                        if (listed[index] != (masks[index] & stored))
+                            return false;
+
+                    return true;
+                }
+
+                // Whether every registered type is part of the snapshot
+                bool covers_(ECSComponentManager& component_manager) const
+                {
+                    ECSMask covered;
+                    for (auto const& type : types_)
+                        covered.set(type.type(component_manager));
+                    for (auto const& tag : tags_)
+                        covered.set(tag.type(component_manager));
+
+                    return (component_manager.get_registered_mask() & ~covered).none();
+                }
+
+                std::vector<Type> types_{};
+                std::vector<Tag> tags_{};
+        };
+    }
+}
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "ecs_types.hpp"
+
+namespace engine
+{
+    namespace ecs
+    {
+        // A sparse set of entities.
+        // A paged sparse array maps an entity index to its slot in a packed (dense)
+        // array of entity handles, so that lookup, insertion and swap-removal are
+        // all O(1) without any hashing. Pages are only allocated for the index
+        // ranges that are actually used. A stale handle (same index, older
+        // version) is never considered part of the set.
+        class ECSSparseSet
+        {
+            public:
+                static constexpr std::uint32_t PAGE_SIZE = 4096;
+                static constexpr std::uint32_t INVALID_INDEX = ~std::uint32_t(0);
+
+                using iterator = std::vector<ECSEntity>::const_iterator;
+
+                bool contains(ECSEntity entity) const
+                {
+                    ECSEntityIndex index = entity_index(entity);
+                    std::uint32_t page = index / PAGE_SIZE;
+
+                    if (page >= pages_.size() || !pages_[page])
+                        return false;
+
+                    std::uint32_t slot = (*pages_[page])[index % PAGE_SIZE];
+
+                    return slot != INVALID_INDEX && dense_[slot] == entity;
+                }
+
+                std::uint32_t index_of(ECSEntity entity) const
+                {
+                    assert(contains(entity) && "Entity not in sparse set.");
+
+                    ECSEntityIndex index = entity_index(entity);
+
+                    return (*pages_[index / PAGE_SIZE])[index % PAGE_SIZE];
+                }
+
+                std::uint32_t insert(ECSEntity entity)
+                {
+                    assert(!contains(entity) && "Entity added to sparse set more than once.");
+
+                    // Put new entry at end of the dense array and point the sparse slot to it
+                    std::uint32_t index = static_cast<std::uint32_t>(dense_.size());
+                    dense_.push_back(entity);
+                    sparse_slot_(entity) = index;
+                    ++version_;
+
+                    return index;
+                }
+
+                // Appends count entities, none of them already in the set
+                void insert(ECSEntity const* entities, std::size_t count)
+                {
+                    std::uint32_t first = static_cast<std::uint32_t>(dense_.size());
+                    dense_.insert(dense_.end(), entities, entities + count);
+                    ++version_;
+
+                    for (std::uint32_t i = 0; i < count; ++i)
+                    {
+                        assert(!contains(entities[i]) && "Entity added to sparse set more than once.");
+
+                        sparse_slot_(entities[i]) = first + i;
+                    }
+                }
+
+                // Swap-removes the entity and returns the dense slot it used to occupy.
+                // The owner of any array parallel to the dense one must apply the same
+                // swap (last element into the returned slot) to stay in sync.
+                std::uint32_t remove(ECSEntity entity)
+                {
+                    std::uint32_t index = index_of(entity);
+                    ECSEntity last_entity = dense_.back();
+
+                    // Copy element at end into deleted element's place to maintain density
+                    dense_[index] = last_entity;
+                    sparse_slot_(last_entity) = index;
+
+                    sparse_slot_(entity) = INVALID_INDEX;
+                    dense_.pop_back();
+                    ++version_;
+
+                    return index;
+                }
+
+                // Removes count entities of the set at once, none listed twice. The
+                // slots they free below the new size are filled with the survivors
+                // found past it, calling moved(from, to) for each, so that the owner
+                // of parallel arrays can apply the same moves before shrinking them.
+                template<typename F>
+                void remove(ECSEntity const* entities, std::size_t count, F&& moved)
+                {
+                    std::uint32_t size = static_cast<std::uint32_t>(dense_.size() - count);
+
+                    std::vector<std::uint32_t> holes;
+                    for (std::size_t i = 0; i < count; ++i)
+                    {
+                        std::uint32_t index = index_of(entities[i]);
+
+                        sparse_slot_(entities[i]) = INVALID_INDEX;
+                        dense_[index] = NULL_ENTITY;
+
+                        if (index < size)
+                            holes.push_back(index);
+                    }
+
+                    // As many survivors past the new size as holes below it
+                    std::uint32_t survivor = size;
+                    for (std::uint32_t hole : holes)
+                    {
+                        while (dense_[survivor] == NULL_ENTITY)
+                            ++survivor;
+
+                        dense_[hole] = dense_[survivor];
+                        sparse_slot_(dense_[hole]) = hole;
+                        moved(survivor, hole);
+
+                        ++survivor;
+                    }
+
+                    dense_.resize(size);
+                    ++version_;
+                }
+
+                // Exchanges two dense slots, keeping the sparse index in sync
+                void swap(std::uint32_t a, std::uint32_t b)
+                {
+                    std::swap(dense_[a], dense_[b]);
+
+                    sparse_slot_(dense_[a]) = a;
+                    sparse_slot_(dense_[b]) = b;
+                }
+
+                void clear()
+                {
+                    for (ECSEntity entity : dense_)
+                        sparse_slot_(entity) = INVALID_INDEX;
+
+                    dense_.clear();
+                    ++version_;
+                }
+
+                // Replaces the content of the set with count entities, in order
+                void assign(ECSEntity const* entities, std::size_t count)
+                {
+                    clear();
+
+                    dense_.assign(entities, entities + count);
+
+                    for (std::uint32_t i = 0; i < count; ++i)
+                        sparse_slot_(dense_[i]) = i;
+                }
+
+                // Bumped by every insertion and removal - not by swaps, which keep
+                // the same members - for caches of the membership to compare
+                std::uint32_t get_version() const
+                {
+                    return version_;
+                }
+
+                void reserve(std::size_t capacity)
+                {
+                    dense_.reserve(capacity);
+                }
+
+                std::size_t size() const
+                {
+                    return dense_.size();
+                }
+
+                bool empty() const
+                {
+                    return dense_.empty();
+                }
+
+                ECSEntity const* data() const
+                {
+                    return dense_.data();
+                }
+
+                ECSEntity operator[](std::size_t index) const
+                {
+                    return dense_[index];
+                }
+
+                iterator begin() const
+                {
+                    return dense_.begin();
+                }
+
+                iterator end() const
+                {
+                    return dense_.end();
+                }
+
+            private:
+                using Page = std::array<std::uint32_t, PAGE_SIZE>;
+
+                // Returns the sparse slot of an entity, allocating its page if needed.
+                std::uint32_t& sparse_slot_(ECSEntity entity)
+                {
+                    ECSEntityIndex index = entity_index(entity);
+                    std::uint32_t page = index / PAGE_SIZE;
+
+                    if (page >= pages_.size())
+                        pages_.resize(page + 1);
+
+                    if (!pages_[page])
+                    {
+                        pages_[page] = std::make_unique<Page>();
+                        pages_[page]->fill(INVALID_INDEX);
+                    }
+
+                    return (*pages_[page])[index % PAGE_SIZE];
+                }
+
+                // Pages of dense indices, indexed by entity index.
+                std::vector<std::unique_ptr<Page>> pages_{};
+
+                // The packed array of entities.
+                std::vector<ECSEntity> dense_{};
+
+                std::uint32_t version_ = 0;
+        };
+    }
+}
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+namespace engine
+{
+    namespace ecs
+    {
+        // The world states (see Coordinator::save_state) of the last frames, for
+        // rollback and replay.
+        // Only the newest state is kept whole. Every older one is stored as a
+        // backward delta: the XOR of the state with the next one, run-length
+        // encoded. Consecutive frames mostly differ in a few component values,
+        // so a delta is mostly runs of zeros and costs a fraction of a state.
+        // A delta is never bigger than its state, which is stored as it is when
+        // too much of it changed: the history holds at most capacity states.
+        class ECSStateHistory
+        {
+            public:
+                explicit ECSStateHistory(std::size_t capacity)
+                    : capacity_(capacity)
+                {
+                    assert(capacity > 0 && "State history needs room for at least one state.");
+                }
+
+                // Records a new newest state, dropping the oldest one when full
+                void push(std::vector<std::byte> const& state)
+                {
+                    if (size_ > 0)
+                    {
+                        // The previous newest state becomes a delta against this one
+                        Delta delta;
+                        delta.size = latest_.size();
+                        delta.raw = !encode_(latest_, state, delta.data);
+
+                        if (delta.raw)
+                            delta.data = std::move(latest_);
+
+                        deltas_.push_back(std::move(delta));
+
+                        if (deltas_.size() == capacity_)
+                            deltas_.pop_front();
+                    }
+
+                    latest_ = state;
+                    size_ = deltas_.size() + 1;
+                }
+
+                // Rebuilds the state recorded frames_back pushes ago (0 is the newest)
+                // into out. Returns false if it is not in the history anymore.
+                bool get(std::size_t frames_back, std::vector<std::byte>& out) const
+                {
+                    if (frames_back >= size_)
+                        return false;
+
+                    out = latest_;
+
+                    for (std::size_t i = 0; i < frames_back; ++i)
+                    {
+                        Delta const& delta = deltas_[deltas_.size() - 1 - i];
+
+                        if (delta.raw)
+                            out = delta.data;
+                        else
+                            decode_(delta.data, out, delta.size);
+                    }
+
+                    return true;
+                }
+
+                // Forgets the states newer than the one frames_back pushes ago, which
+                // becomes the newest - after rolling back to it
+                void rewind(std::size_t frames_back)
+                {
+                    assert(frames_back < size_ && "Rewinding past the oldest state.");
+
+                    std::vector<std::byte> state;
+                    get(frames_back, state);
+
+                    deltas_.resize(deltas_.size() - frames_back);
+                    latest_ = std::move(state);
+                    size_ = deltas_.size() + 1;
+                }
+
+                std::size_t size() const
+                {
+                    return size_;
+                }
+
+                std::size_t capacity() const
+                {
+                    return capacity_;
+                }
+
+                // Bytes held by the history
+                std::size_t get_memory_usage() const
+                {
+                    std::size_t bytes = latest_.size();
+                    for (auto const& delta : deltas_)
+                        bytes += delta.data.size();
+
+                    return bytes;
+                }
+
+                void clear()
+                {
+                    latest_.clear();
+                    deltas_.clear();
+                    size_ = 0;
+                }
+
+            private:
+                struct Delta
+                {
+                    // Encoded XOR of the state with the next one, or the state itself
+                    std::vector<std::byte> data;
+                    // Size of the state
+                    std::size_t size;
+                    bool raw;
+                };
+
+                // A delta is a sequence of runs: the number of unchanged bytes, the
+                // number of changed bytes, then the changed bytes XOR-ed together.
+                // Unchanged gaps shorter than a run header stay in the changed bytes
+                // (e.g. the equal exponent byte of a moved position), so that a
+                // changed value costs one run. States of different sizes are compared
+                // as if the shorter one was padded with zeros.
+                // Returns false, out left incomplete, if the delta would not be
+                // smaller than the older state.
+                bool encode_(std::vector<std::byte> const& older, std::vector<std::byte> const& newer, std::vector<std::byte>& out)
+                {
+                    constexpr std::size_t HEADER = 2 * sizeof(std::uint32_t);
+
+                    out.clear();
+
+                    // XOR of the states in one pass, scanned for runs of zeros below
+                    std::size_t size = std::max(older.size(), newer.size());
+                    diff_.assign(size, std::byte(0));
+
+                    // Plain pointers: bytes written through the vector could alias
+                    // anything, its own data pointer included
+                    std::byte* diff = diff_.data();
+                    std::byte const* next = newer.data();
+
+                    if (!older.empty())
+                        std::memcpy(diff, older.data(), older.size());
+
+                    std::size_t i = 0;
+                    for (std::uint64_t a, b; i + sizeof(a) <= newer.size(); i += sizeof(a))
+                    {
+                        std::memcpy(&a, diff + i, sizeof(a));
+                        std::memcpy(&b, next + i, sizeof(b));
+                        a ^= b;
+                        std::memcpy(diff + i, &a, sizeof(a));
+                    }
+
+                    for (; i < newer.size(); ++i)
+                        diff[i] ^= next[i];
+
+                    i = 0;
+                    while (i < size)
+                    {
+                        // Unchanged bytes, 8 at a time
+                        std::size_t zeros = i;
+                        for (std::uint64_t word; zeros + sizeof(word) <= size; zeros += sizeof(word))
+                        {
+                            std::memcpy(&word, diff + zeros, sizeof(word));
+                            if (word != 0)
+                                break;
+                        }
+
+                        while (zeros < size && diff[zeros] == std::byte(0))
+                            ++zeros;
+
+                        // Nothing changed up to the end
+                        if (zeros == size)
+                            break;
+
+                        std::size_t literals = zeros;
+                        while (literals < size)
+                        {
+                            if (diff[literals] != std::byte(0))
+                            {
+                                ++literals;
+                                continue;
+                            }
+
+                            std::size_t gap = literals;
+                            while (gap < size && gap - literals < HEADER && diff[gap] == std::byte(0))
+                                ++gap;
+
+                            if (gap == size || gap - literals == HEADER)
+                                break;
+
+                            literals = gap;
+                        }
+
+                        std::uint32_t run[2] = {
+                            static_cast<std::uint32_t>(zeros - i),
+                            static_cast<std::uint32_t>(literals - zeros)
+                        };
+
+                        std::size_t offset = out.size();
+                        if (offset + HEADER + run[1] >= older.size())
+                            return false;
+
+                        out.resize(offset + HEADER + run[1]);
+                        std::memcpy(out.data() + offset, run, HEADER);
+                        std::memcpy(out.data() + offset + HEADER, diff + zeros, run[1]);
+
+                        i = literals;
+                    }
+
+                    return true;
+                }
+
+                // Turns state into the state before it, of the given size
+                static void decode_(std::vector<std::byte> const& delta, std::vector<std::byte>& state, std::size_t size)
+                {
+                    state.resize(std::max(state.size(), size));
+
+                    std::size_t i = 0;
+                    std::size_t offset = 0;
+                    while (offset < delta.size())
+                    {
+                        std::uint32_t run[2];
+                        std::memcpy(run, delta.data() + offset, sizeof(run));
+                        offset += sizeof(run);
+
+                        i += run[0];
+                        for (std::size_t j = 0; j < run[1]; ++j)
+                            state[i + j] ^= delta[offset + j];
+
+                        i += run[1];
+                        offset += run[1];
+                    }
+
+                    state.resize(size);
+                }
+
+                std::size_t capacity_;
+                std::size_t size_ = 0;
+
+                std::vector<std::byte> latest_{};
+
+                // Oldest first
+                std::deque<Delta> deltas_{};
+
+                // Scratch XOR of the states, kept between pushes
+                std::vector<std::byte> diff_{};
+        };
+    }
+}
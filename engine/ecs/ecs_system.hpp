@@ -1,8 +1,8 @@
 #pragma once
 
-#include <set>
-
 #include "ecs_types.hpp"
+#include "ecs_type_id.hpp"
+#include "ecs_sparse_set.hpp"
 
 namespace engine
 {
@@ -11,7 +11,42 @@ namespace engine
 		class ECSSystem
 		{
 			public:
-				std::set<ECSEntity> entities_;
+				virtual ~ECSSystem() = default;
+
+				virtual void update(float dt)
+				{}
+
+				// Component types read and written by update, used by the scheduler
+				// to decide which systems may run concurrently
+				ECSMask get_reads() const
+				{
+					return reads_;
+				}
+
+				ECSMask get_writes() const
+				{
+					return writes_;
+				}
+
+				// Entities matching the system mask, packed for cache-friendly iteration
+				ECSSparseSet entities_;
+
+			protected:
+				template<typename... Ts>
+				void reads()
+				{
+					(reads_.set(ECSTypeId<ECSComponentFamily>::get<Ts>()), ...);
+				}
+
+				template<typename... Ts>
+				void writes()
+				{
+					(writes_.set(ECSTypeId<ECSComponentFamily>::get<Ts>()), ...);
+				}
+
+			private:
+				ECSMask reads_;
+				ECSMask writes_;
 		};
 	}
 }
\ No newline at end of file
@@ -1,10 +1,14 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <memory>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "ecs_types.hpp"
+#include "ecs_type_id.hpp"
 #include "ecs_system.hpp"
 
 namespace engine
@@ -14,16 +18,23 @@ namespace engine
         class ECSSystemManager
         {
             public:
-                template<typename T>
-                std::shared_ptr<T> register_system()
+                // The arguments are forwarded to the constructor of the system
+                template<typename T, typename... Args>
+                std::shared_ptr<T> register_system(Args&&... args)
                 {
-                    const char* type_name = typeid(T).name();
+                    std::uint32_t type = ECSTypeId<ECSSystemFamily>::get<T>();
+
+                    if (type >= systems_.size())
+                    {
+                        systems_.resize(type + 1);
+                        masks_.resize(type + 1);
+                    }
 
-                    assert(systems_.find(type_name) == systems_.end() && "Registering system more than once.");
+                    assert(!systems_[type] && "Registering system more than once.");
 
                     // Create a pointer to the system and return it so it can be used externally
-                    auto system = std::make_shared<T>();
-                    systems_.insert({type_name, system});
+                    auto system = std::make_shared<T>(std::forward<Args>(args)...);
+                    systems_[type] = system;
 
                     return system;
                 }
@@ -31,49 +42,150 @@ namespace engine
                 template<typename T>
                 void set_mask(ECSMask mask)
                 {
-                    const char* type_name = typeid(T).name();
+                    std::uint32_t type = ECSTypeId<ECSSystemFamily>::get<T>();
 
-                    assert(systems_.find(type_name) != systems_.end() && "System used before registered.");
+                    assert(type < systems_.size() && systems_[type] && "System used before registered.");
+                    assert(mask.any() && "System mask must contain at least one component.");
+
+                    // Unindex the previous mask, if any
+                    for (ECSComponentType component = 0; component < MAX_COMPONENTS; ++component)
+                    {
+                        if (masks_[type].test(component))
+                        {
+                            auto& systems = systems_by_component_[component];
+                            systems.erase(std::find(systems.begin(), systems.end(), type));
+                        }
+                    }
 
                     // Set the mask for this system
-                    masks_.insert({type_name, mask});
+                    masks_[type] = mask;
+
+                    // Index the system by each of its component types
+                    for (ECSComponentType component = 0; component < MAX_COMPONENTS; ++component)
+                    {
+                        if (mask.test(component))
+                            systems_by_component_[component].push_back(static_cast<std::uint32_t>(type));
+                    }
+                }
+
+                void entity_destroyed(ECSEntity entity, ECSMask entity_mask)
+                {
+                    // Erase a destroyed entity from the lists of the systems it was part of,
+                    // i.e. the ones whose mask is matched by the entity's mask
+                    for (std::size_t type = 0; type < systems_.size(); ++type)
+                    {
+                        auto const& system = systems_[type];
+                        auto const& system_mask = masks_[type];
+
+                        if (system && system_mask.any() && (entity_mask & system_mask) == system_mask)
+                            system->entities_.remove(entity);
+                    }
                 }
 
-                void entity_destroyed(ECSEntity entity)
+                // Destroyed entities, listed once each with their masks: every system
+                // loses all of its entities of the batch at once
+                void entities_destroyed(ECSEntity const* entities, ECSMask const* entity_masks, std::size_t count)
                 {
-                    // Erase a destroyed entity from all system lists
-                    // mEntities is a set so no check needed
-                    for (auto const& pair : systems_)
+                    std::vector<ECSEntity> members;
+
+                    for (std::size_t type = 0; type < systems_.size(); ++type)
                     {
-                        auto const& system = pair.second;
-                        system->entities_.erase(entity);
+                        auto const& system = systems_[type];
+                        auto const& system_mask = masks_[type];
+
+                        if (!system || system_mask.none())
+                            continue;
+
+                        members.clear();
+                        for (std::size_t i = 0; i < count; ++i)
+                            if ((entity_masks[i] & system_mask) == system_mask)
+                                members.push_back(entities[i]);
+
+                        if (!members.empty())
+                            system->entities_.remove(members.data(), members.size(), [](std::uint32_t, std::uint32_t) {});
                     }
                 }
 
-                void entity_mask_changed(ECSEntity entity, ECSMask entity_mask)
+                // Adds new entities, all with the same mask, to the lists of the
+                // systems it matches - one pass over the systems for all of them
+                void entities_created(ECSEntity const* entities, std::size_t count, ECSMask entity_mask)
                 {
-                    // Notify each system that an entity's mask changed
-                    for (auto const& pair : systems_)
+                    for (std::size_t type = 0; type < systems_.size(); ++type)
                     {
-                        auto const& type = pair.first;
-                        auto const& system = pair.second;
+                        auto const& system = systems_[type];
                         auto const& system_mask = masks_[type];
 
-                        // Entity mask matches system mask - insert into set
-                        if ((entity_mask & system_mask) == system_mask)
-                            system->entities_.insert(entity);
-                        // Entity mask does not match system mask - erase from set
-                        else
-                            system->entities_.erase(entity);
+                        if (system && system_mask.any() && (entity_mask & system_mask) == system_mask)
+                            system->entities_.insert(entities, count);
+                    }
+                }
+
+                // Replaces the entity lists of every system with the entities of a
+                // whole new world - one pass over the masks and one bulk insertion
+                // per system
+                void assign_entities(ECSEntity const* entities, ECSMask const* entity_masks, std::size_t count)
+                {
+                    std::vector<ECSEntity> matched;
+
+                    for (std::size_t type = 0; type < systems_.size(); ++type)
+                    {
+                        auto const& system = systems_[type];
+                        auto const& system_mask = masks_[type];
+
+                        if (!system)
+                            continue;
+
+                        matched.clear();
+                        if (system_mask.any())
+                            for (std::size_t i = 0; i < count; ++i)
+                                if ((entity_masks[i] & system_mask) == system_mask)
+                                    matched.push_back(entities[i]);
+
+                        system->entities_.assign(matched.data(), matched.size());
+                    }
+                }
+
+                void entity_mask_changed(ECSEntity entity, ECSMask old_mask, ECSMask new_mask)
+                {
+                    ECSMask changed = old_mask ^ new_mask;
+
+                    // Only the systems whose mask involves a flipped component bit can be affected
+                    for (ECSComponentType component = 0; component < MAX_COMPONENTS; ++component)
+                    {
+                        if (!changed.test(component))
+                            continue;
+
+                        for (std::uint32_t type : systems_by_component_[component])
+                        {
+                            auto const& system = systems_[type];
+                            auto const& system_mask = masks_[type];
+
+                            bool matched = (old_mask & system_mask) == system_mask;
+                            bool matches = (new_mask & system_mask) == system_mask;
+
+                            // A system involving several flipped bits is visited once per bit
+                            if (matched == matches || system->entities_.contains(entity) == matches)
+                                continue;
+
+                            // Entity mask now matches system mask - insert into list
+                            if (matches)
+                                system->entities_.insert(entity);
+                            // Entity mask no longer matches system mask - erase from list
+                            else
+                                system->entities_.remove(entity);
+                        }
                     }
                 }
 
             private:
-                // Map from system type string pointer to a mask
-                std::unordered_map<const char*, ECSMask> masks_{};
+                // Masks, indexed by system type
+                std::vector<ECSMask> masks_{};
+
+                // Systems, indexed by system type
+                std::vector<std::shared_ptr<ECSSystem>> systems_{};
 
-                // Map from system type string pointer to a system pointer
-                std::unordered_map<const char*, std::shared_ptr<ECSSystem>> systems_{};
+                // System types whose mask contains a component type, indexed by component type
+                std::array<std::vector<std::uint32_t>, MAX_COMPONENTS> systems_by_component_{};
         };
     }
 }
\ No newline at end of file
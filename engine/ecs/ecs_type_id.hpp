@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+namespace engine
+{
+    namespace ecs
+    {
+        // Process-wide, dense IDs assigned to types the first time they are queried.
+        // Each family (components, systems, ...) has its own counter starting at 0,
+        // so IDs can directly index flat arrays. After the first call, getting
+        // the ID of a type is a single load of a function-local static.
+        template<typename Family>
+        class ECSTypeId
+        {
+            public:
+                template<typename T>
+                static std::uint32_t get()
+                {
+                    return id_<std::remove_cv_t<T>>();
+                }
+
+            private:
+                template<typename T>
+                static std::uint32_t id_()
+                {
+                    static const std::uint32_t id = next_.fetch_add(1, std::memory_order_relaxed);
+
+                    return id;
+                }
+
+                inline static std::atomic<std::uint32_t> next_{0};
+        };
+
+        // Type ID families
+        struct ECSComponentFamily;
+        struct ECSResourceFamily;
+        struct ECSSystemFamily;
+    }
+}
\ No newline at end of file
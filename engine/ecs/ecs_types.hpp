@@ -1,17 +1,57 @@
 #pragma once
 
 #include <bitset>
+#include <cstdint>
 
 namespace engine
 {
     namespace ecs
     {
-        using ECSEntity = std::uint32_t;
-        const ECSEntity MAX_ENTITIES = 5000;
+        // Generational entity handle: the low 32 bits are the index of the entity
+        // (reused once destroyed) and the high 32 bits its version, bumped every
+        // time the index is recycled so that stale handles can be detected.
+        using ECSEntity = std::uint64_t;
+        using ECSEntityIndex = std::uint32_t;
+        using ECSEntityVersion = std::uint32_t;
+
+        // Upper bound of the entity index space - storage grows with use, not with this value
+        const ECSEntityIndex MAX_ENTITY = ~ECSEntityIndex(0);
+
+        // Handle that never refers to a living entity
+        const ECSEntity NULL_ENTITY = ~ECSEntity(0);
+
+        inline ECSEntity make_entity(ECSEntityIndex index, ECSEntityVersion version)
+        {
+            return (static_cast<ECSEntity>(version) << 32) | index;
+        }
+
+        inline ECSEntityIndex entity_index(ECSEntity entity)
+        {
+            return static_cast<ECSEntityIndex>(entity);
+        }
+
+        inline ECSEntityVersion entity_version(ECSEntity entity)
+        {
+            return static_cast<ECSEntityVersion>(entity >> 32);
+        }
 
         using ECSComponentType = std::uint8_t;
         const ECSComponentType MAX_COMPONENTS = 32;
 
         using ECSMask = std::bitset<MAX_COMPONENTS>;
+
+        // Logical time used by change tracking. Tick 0 is never handed out, so
+        // "changed since tick 0" means every component.
+        using ECSTick = std::uint32_t;
+
+        // How the ComponentManager lays out component data
+        enum class ECSStorageMode
+        {
+            // One packed array per component type (default)
+            SPARSE_SET,
+            // Entities sharing a mask are stored together in fixed-size chunks,
+            // one column per component type
+            ARCHETYPE
+        };
     }
 }
\ No newline at end of file
@@ -0,0 +1,435 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ecs_types.hpp"
+#include "ecs_component_array.hpp"
+#include "ecs_component_manager.hpp"
+#include "ecs_entity_manager.hpp"
+
+#include "utils_aligned_allocator.hpp"
+#include "utils_job_system.hpp"
+
+namespace engine
+{
+    namespace ecs
+    {
+        // Smallest number of consecutive elements of each of the types that spans
+        // whole cache lines. Parallel ranges split on multiples of it never write
+        // to the same cache line of a packed component array.
+        template<typename... Ts>
+        constexpr std::size_t cache_line_elements()
+        {
+            std::size_t elements = 1;
+            ((elements = std::lcm(elements, utils::CACHE_LINE_SIZE / std::gcd(utils::CACHE_LINE_SIZE, sizeof(Ts)))), ...);
+
+            return elements;
+        }
+
+        // Range size used to split count elements over the threads of a job system:
+        // a few ranges per thread for load balancing, rounded up to whole cache lines.
+        inline std::size_t parallel_grain(std::size_t count, std::size_t nb_threads, std::size_t granularity)
+        {
+            std::size_t grain = std::max<std::size_t>(count / (nb_threads * 4), 1);
+
+            return (grain + granularity - 1) / granularity * granularity;
+        }
+
+        // A typed view over all the entities owning a set of components.
+        // Iteration walks the packed entities of the smallest component array and
+        // filters them with the entity masks, so the cost per entity is one mask
+        // load plus one sparse lookup per component.
+        // Components declared const are only handed out as const references;
+        // the others are recorded as changed when their type is change-tracked.
+        // Structural changes (add/remove/destroy) are not allowed while iterating.
+        template<typename... Ts>
+        class ECSView
+        {
+            static_assert(sizeof...(Ts) > 0, "A view needs at least one component.");
+            static_assert((!std::is_empty<Ts>::value && ...), "Tag components are filtered with with<Tags...>().");
+
+            public:
+                using Tuple = std::tuple<Ts&...>;
+
+                ECSView() = default;
+
+                ECSView(ECSEntityManager const* entity_manager, ECSComponentManager* component_manager)
+                    : entity_manager_(entity_manager),
+                      component_manager_(component_manager),
+                      arrays_(component_manager->get_component_array<std::remove_const_t<Ts>>()...),
+                      types_{ component_manager->get_component_type<std::remove_const_t<Ts>>()... }
+                {
+                    for (ECSComponentType type : types_)
+                        include_.set(type);
+                }
+
+                // Returns a copy of the view only keeping entities owning all the given
+                // components as well - typically tags, which have no data to hand out
+                template<typename... Included>
+                ECSView with() const
+                {
+                    ECSView view = *this;
+                    (view.include_.set(component_manager_->get_component_type<Included>()), ...);
+
+                    return view;
+                }
+
+                // Returns a copy of the view skipping entities owning any of the given components
+                template<typename... Excluded>
+                ECSView without() const
+                {
+                    ECSView view = *this;
+                    (view.exclude_.set(component_manager_->get_component_type<Excluded>()), ...);
+
+                    return view;
+                }
+
+                bool contains(ECSEntity entity) const
+                {
+                    ECSMask mask = entity_manager_->get_mask(entity);
+
+                    return (mask & include_) == include_ && (mask & exclude_).none();
+                }
+
+                Tuple get(ECSEntity entity) const
+                {
+                    return get_(entity, std::index_sequence_for<Ts...>{});
+                }
+
+                // Calls fn(entity, Ts&...) for every matching entity
+                template<typename F>
+                void each(F&& fn) const
+                {
+                    each_(fn, std::index_sequence_for<Ts...>{});
+                }
+
+                // Calls fn(entity, Ts&...) for every matching entity, split over the
+                // threads of the job system. fn runs concurrently for different
+                // entities, so it must only write to the components it is given.
+                template<typename F>
+                void parallel_each(utils::JobSystem& job_system, F&& fn) const
+                {
+                    parallel_each_(job_system, fn, std::index_sequence_for<Ts...>{});
+                }
+
+                class iterator
+                {
+                    public:
+                        iterator(ECSView const* view, ECSEntity const* current, ECSEntity const* end)
+                            : view_(view), current_(current), end_(end)
+                        {
+                            skip_();
+                        }
+
+                        Tuple operator*() const
+                        {
+                            return view_->get(*current_);
+                        }
+
+                        iterator& operator++()
+                        {
+                            ++current_;
+                            skip_();
+
+                            return *this;
+                        }
+
+                        bool operator!=(iterator const& other) const
+                        {
+                            return current_ != other.current_;
+                        }
+
+                    private:
+                        void skip_()
+                        {
+                            while (current_ != end_ && !view_->contains(*current_))
+                                ++current_;
+                        }
+
+                        ECSView const* view_;
+                        ECSEntity const* current_;
+                        ECSEntity const* end_;
+                };
+
+                iterator begin() const
+                {
+                    auto [entities, count] = driver_();
+
+                    return iterator(this, entities, entities + count);
+                }
+
+                iterator end() const
+                {
+                    auto [entities, count] = driver_();
+
+                    return iterator(this, entities + count, entities + count);
+                }
+
+                ECSMask get_include_mask() const
+                {
+                    return include_;
+                }
+
+                ECSMask get_exclude_mask() const
+                {
+                    return exclude_;
+                }
+
+                ECSComponentManager* get_component_manager() const
+                {
+                    return component_manager_;
+                }
+
+                std::tuple<ECSComponentArray<std::remove_const_t<Ts>>*...> const& get_arrays() const
+                {
+                    return arrays_;
+                }
+
+                // The packed entities of the smallest component array, which drive iteration
+                std::pair<ECSEntity const*, std::size_t> driver() const
+                {
+                    return driver_();
+                }
+
+                // Elements per parallel range boundary: whole cache lines of the
+                // entities and components, and of the change ticks written along
+                // with non-const components of tracked types
+                std::size_t get_parallel_granularity() const
+                {
+                    bool tracked = false;
+                    std::apply([&](auto*... arrays)
+                    {
+                        ((tracked = tracked || (!std::is_const_v<Ts> && arrays->is_change_tracking_enabled())), ...);
+                    }, arrays_);
+
+                    if (tracked)
+                        return cache_line_elements<ECSEntity, ECSTick, Ts...>();
+
+                    return cache_line_elements<ECSEntity, Ts...>();
+                }
+
+            private:
+                std::pair<ECSEntity const*, std::size_t> driver_() const
+                {
+                    ECSEntity const* entities = nullptr;
+                    std::size_t count = std::numeric_limits<std::size_t>::max();
+
+                    auto consider = [&](auto* array)
+                    {
+                        if (array->size() < count)
+                        {
+                            entities = array->entities();
+                            count = array->size();
+                        }
+                    };
+                    std::apply([&](auto*... arrays) { (consider(arrays), ...); }, arrays_);
+
+                    return { entities, count };
+                }
+
+                template<typename T>
+                static T& fetch_(ECSComponentArray<std::remove_const_t<T>>* array, ECSEntity entity)
+                {
+                    if constexpr (std::is_const_v<T>)
+                        return array->get(entity);
+                    else
+                        return array->write(entity);
+                }
+
+                template<std::size_t... Is>
+                Tuple get_(ECSEntity entity, std::index_sequence<Is...>) const
+                {
+                    return Tuple(fetch_<Ts>(std::get<Is>(arrays_), entity)...);
+                }
+
+                template<typename F, std::size_t... Is>
+                void each_(F& fn, std::index_sequence<Is...>) const
+                {
+                    auto [entities, count] = driver_();
+
+                    for (std::size_t i = 0; i < count; ++i)
+                    {
+                        ECSEntity entity = entities[i];
+
+                        if (contains(entity))
+                            fn(entity, fetch_<Ts>(std::get<Is>(arrays_), entity)...);
+                    }
+                }
+
+                template<typename F, std::size_t... Is>
+                void parallel_each_(utils::JobSystem& job_system, F& fn, std::index_sequence<Is...>) const
+                {
+                    auto [entities, count] = driver_();
+
+                    // Ranges are cut on cache-line multiples of the driving array, which
+                    // is also the array order of the others when entities were added to
+                    // all of them in the same order
+                    std::size_t grain = parallel_grain(count, job_system.get_thread_count(), get_parallel_granularity());
+
+                    job_system.parallel_for(0, count, grain, [&](std::size_t begin, std::size_t end)
+                    {
+                        for (std::size_t i = begin; i < end; ++i)
+                        {
+                            ECSEntity entity = entities[i];
+
+                            if (contains(entity))
+                                fn(entity, fetch_<Ts>(std::get<Is>(arrays_), entity)...);
+                        }
+                    });
+                }
+
+                ECSEntityManager const* entity_manager_ = nullptr;
+                ECSComponentManager* component_manager_ = nullptr;
+
+                std::tuple<ECSComponentArray<std::remove_const_t<Ts>>*...> arrays_{};
+                std::array<ECSComponentType, sizeof...(Ts)> types_{};
+
+                ECSMask include_{};
+                ECSMask exclude_{};
+        };
+
+        // A view whose matches are cached across frames.
+        // The cache stores, for every match, the dense index of each of its
+        // components, so iterating it is a raw array walk. It is rebuilt when
+        // any included or excluded component type had a structural change, or
+        // when included components moved in their arrays - the walk then follows
+        // their new order.
+        template<typename... Ts>
+        class ECSQuery
+        {
+            public:
+                ECSQuery() = default;
+
+                explicit ECSQuery(ECSView<Ts...> const& view)
+                    : view_(view)
+                {}
+
+                // Calls fn(entity, Ts&...) for every matching entity
+                template<typename F>
+                void each(F&& fn)
+                {
+                    refresh();
+
+                    each_(fn, 0, entities_.size(), std::index_sequence_for<Ts...>{});
+                }
+
+                // Calls fn(entity, Ts&...) for every matching entity, split over the
+                // threads of the job system. fn must only write to the components it is given.
+                template<typename F>
+                void parallel_each(utils::JobSystem& job_system, F&& fn)
+                {
+                    refresh();
+
+                    std::size_t grain = parallel_grain(entities_.size(), job_system.get_thread_count(), view_.get_parallel_granularity());
+
+                    job_system.parallel_for(0, entities_.size(), grain, [&](std::size_t begin, std::size_t end)
+                    {
+                        each_(fn, begin, end, std::index_sequence_for<Ts...>{});
+                    });
+                }
+
+                std::size_t size()
+                {
+                    refresh();
+
+                    return entities_.size();
+                }
+
+                // Rebuilds the cache if it is stale
+                void refresh()
+                {
+                    ECSMask included = view_.get_include_mask();
+                    ECSMask excluded = view_.get_exclude_mask();
+                    ECSComponentManager* component_manager = view_.get_component_manager();
+
+                    // Included types hold the cached indices: any move counts.
+                    // Excluded types only matter through their owners.
+                    bool stale = !built_;
+                    for (ECSComponentType type = 0; type < MAX_COMPONENTS; ++type)
+                    {
+                        std::uint32_t version = included.test(type) ? component_manager->get_order_version(type)
+                            : excluded.test(type) ? component_manager->get_version(type)
+                            : versions_[type];
+
+                        if (versions_[type] != version)
+                        {
+                            versions_[type] = version;
+                            stale = true;
+                        }
+                    }
+
+                    if (stale)
+                        rebuild_(std::index_sequence_for<Ts...>{});
+                }
+
+            private:
+                static constexpr std::size_t COUNT = sizeof...(Ts);
+
+                template<std::size_t... Is>
+                void rebuild_(std::index_sequence<Is...>)
+                {
+                    entities_.clear();
+                    indices_.clear();
+
+                    // Walk the matches by hand: going through the view would record
+                    // every written component as changed
+                    auto const& arrays = view_.get_arrays();
+                    auto [entities, count] = view_.driver();
+
+                    for (std::size_t i = 0; i < count; ++i)
+                    {
+                        ECSEntity entity = entities[i];
+
+                        if (!view_.contains(entity))
+                            continue;
+
+                        entities_.push_back(entity);
+                        indices_.push_back({ std::get<Is>(arrays)->index_of(entity)... });
+                    }
+
+                    built_ = true;
+                }
+
+                template<typename F, std::size_t... Is>
+                void each_(F& fn, std::size_t begin, std::size_t end, std::index_sequence<Is...>)
+                {
+                    auto const& arrays = view_.get_arrays();
+
+                    // Fetch the packed component arrays once
+                    auto components = std::make_tuple(std::get<Is>(arrays)->components()...);
+
+                    // Written components of tracked types are recorded as changed
+                    std::array<bool, COUNT> tracked = { (!std::is_const_v<Ts> && std::get<Is>(arrays)->is_change_tracking_enabled())... };
+                    bool any_tracked = ((tracked[Is]) || ...);
+
+                    for (std::size_t i = begin; i < end; ++i)
+                    {
+                        if (any_tracked)
+                            ((tracked[Is] ? std::get<Is>(arrays)->mark_changed_at(indices_[i][Is]) : void()), ...);
+
+                        fn(entities_[i], static_cast<Ts&>(std::get<Is>(components)[indices_[i][Is]])...);
+                    }
+                }
+
+                ECSView<Ts...> view_{};
+
+                // Cached matches and the dense index of each of their components
+                std::vector<ECSEntity> entities_{};
+                std::vector<std::array<std::uint32_t, COUNT>> indices_{};
+
+                // Order versions of the included types and structural versions of
+                // the excluded ones the cache was built against
+                std::array<std::uint32_t, MAX_COMPONENTS> versions_{};
+                bool built_ = false;
+        };
+    }
+}
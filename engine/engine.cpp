@@ -2,112 +2,161 @@
 
 namespace engine
 {
-    std::shared_ptr<Coordinator> coordinator = {};
-    std::shared_ptr<graphics::GraphicsManager> graphics_manager = {};
-    std::shared_ptr<system::PhysicsSystem> physics_system = {};
-    std::shared_ptr<system::CameraControlSystem> camera_control_system = {};
+    void Engine::init(
+        Diligent::NativeWindow native_window,
+        const std::string& assets_path
+    )
+    {
+        job_system_ = std::make_unique<utils::JobSystem>();
 
-    static bool quit = false;
+        world_ = std::make_unique<World>();
+        world_->init(*job_system_);
 
-    void quit_handler(event::Event& event)
-    {
-        quit = true;
+        Coordinator& coordinator = world_->get_coordinator();
+        event_listeners_.push_back(coordinator.add_event_listener(EVENT_METHOD_LISTENER(event::QUIT, Engine::quit_handler_)));
+        event_listeners_.push_back(coordinator.add_event_listener(EVENT_METHOD_LISTENER(event::RESIZE, Engine::resize_handler_)));
+
+        graphics_manager_ = std::make_unique<graphics::GraphicsManager>(assets_path);
+        graphics_manager_->initialize(&native_window);
     }
 
-    void resize_handler(event::Event& event)
+    void Engine::update(double dt)
     {
-        assert(graphics_manager);
+        assert(world_);
+        assert(graphics_manager_);
 
-        int width = event.get_parameter<int>(event::resize::WIDTH);
-        int height = event.get_parameter<int>(event::resize::HEIGHT);
+        // The events recorded until now are replayed before this step, and
+        // exactly the posted ones among them are dispatched by it
+        if (event::EventRecording* recording = recording_.load(std::memory_order_acquire))
+        {
+            Coordinator& coordinator = world_->get_coordinator();
 
-        graphics_manager->resize(width, height);
-    }
+            recording->end_frame(static_cast<float>(dt), [&]()
+            {
+                coordinator.collect_events();
+            });
+        }
 
-    void Engine::init(
-        Diligent::NativeWindow native_window,
-        const std::string& assets_path
-    )
-    {
-        coordinator = std::make_unique<Coordinator>();
-        coordinator->init();
-        coordinator->add_event_listener(EVENT_FUNCTION_LISTENER(event::QUIT, quit_handler));
-        coordinator->add_event_listener(EVENT_FUNCTION_LISTENER(event::RESIZE, resize_handler));
+        world_->step(dt);
 
-        graphics_manager = std::make_unique<graphics::GraphicsManager>(assets_path);
-        graphics_manager->initialize(&native_window);
+        system::CameraControlSystem& camera_control_system = world_->get_camera_control_system();
 
-        /// Register components
+        Diligent::float4x4 camera_view = camera_control_system.look_at();
+        Diligent::float3 camera_position = camera_control_system.get_position();
 
-        coordinator->register_component<component::Transform>();
-        coordinator->register_component<component::Camera>();
-        coordinator->register_component<component::RigidBody>();
-        coordinator->register_component<component::Gravity>();
+        graphics_manager_->set_camera_view(camera_view);
+        graphics_manager_->set_camera_position(camera_position);
 
-        /// Systems
+        graphics_manager_->update(dt);
+    }
 
-        physics_system = coordinator->register_system<system::PhysicsSystem>();
-        {
-            engine::ecs::ECSMask mask;
-            mask.set(coordinator->get_component_type<component::Transform>());
-            mask.set(coordinator->get_component_type<component::Gravity>());
-            mask.set(coordinator->get_component_type<component::RigidBody>());
-            coordinator->set_system_mask<system::PhysicsSystem>(mask);
-        }
+    void Engine::shutdown()
+    {
+        recording_.store(nullptr, std::memory_order_release);
+        recorder_.reset();
 
-        camera_control_system = coordinator->register_system<system::CameraControlSystem>();
-        {
-            engine::ecs::ECSMask mask;
-            mask.set(coordinator->get_component_type<component::Transform>());
-            mask.set(coordinator->get_component_type<component::Camera>());
-            mask.set(coordinator->get_component_type<engine::component::RigidBody>());
-            coordinator->set_system_mask<system::CameraControlSystem>(mask);
-        }
+        event_listeners_.clear();
+        world_.reset();
+        graphics_manager_.reset();
+        job_system_.reset();
+    }
+
+    void Engine::dump_schedule(std::ostream& stream)
+    {
+        assert(world_);
 
-        camera_control_system->init();
+        world_->dump_schedule(stream);
     }
 
-    void Engine::update(double dt)
+    bool Engine::save_world(const std::string& path)
     {
-        assert(camera_control_system);
-        assert(graphics_manager);
-    
-        camera_control_system->update(dt);
-        physics_system->update(dt);
-
-        Diligent::float4x4 camera_view = camera_control_system->look_at();
-        Diligent::float3 camera_position = camera_control_system->get_position();
-
-        graphics_manager->set_camera_view(camera_view);
-        graphics_manager->set_camera_position(camera_position);
-        
-        graphics_manager->update(dt);
+        assert(world_);
+
+        return world_->save(path);
     }
 
-    void Engine::shutdown()
+    bool Engine::load_world(const std::string& path)
     {
-        coordinator.reset();
-        graphics_manager.reset();
-        physics_system.reset();
-        camera_control_system.reset();
+        assert(world_);
+
+        return world_->load(path);
     }
 
     bool Engine::should_quit()
     {
-        return quit;
+        return quit_;
     }
 
     void Engine::send_event(event::Event& event)
     {
-        assert(coordinator);
+        assert(world_);
+
+        if (event::EventRecording* recording = recording_.load(std::memory_order_acquire))
+            recording->record(event, event::EventRecording::Delivery::SENT);
 
-        coordinator->send_event(event);
+        world_->get_coordinator().send_event(event);
     }
-    
+
     void Engine::send_event(event::EventId event_id)
     {
-        assert(coordinator);
+        event::Event event(event_id);
+        send_event(event);
+    }
+
+    bool Engine::post_event(event::Event const& event)
+    {
+        assert(world_);
+
+        Coordinator& coordinator = world_->get_coordinator();
+
+        // Acquire: pairs with start_recording publishing a cleared recording
+        event::EventRecording* recording = recording_.load(std::memory_order_acquire);
+        if (!recording)
+            return coordinator.post_event(event);
+
+        // Recorded first, and queued under the same lock as end_frame collects
+        // the posted events: the event is replayed before the step dispatching it
+        return recording->record(event, event::EventRecording::Delivery::POSTED, [&]()
+        {
+            return coordinator.post_event(event);
+        });
+    }
+
+    void Engine::start_recording()
+    {
+        assert(!recording_.load(std::memory_order_relaxed) && "Already recording.");
+
+        if (!recorder_)
+            recorder_ = std::make_unique<event::EventRecording>();
+
+        recorder_->clear();
+        recording_.store(recorder_.get(), std::memory_order_release);
+    }
+
+    bool Engine::stop_recording(const std::string& path)
+    {
+        assert(recording_.load(std::memory_order_relaxed) && "Not recording.");
+
+        // Posts already past the check may still add events: they come after
+        // the last frame, which is all that is saved
+        recording_.store(nullptr, std::memory_order_release);
+
+        return recorder_->save(path);
+    }
+
+    // MARK: - Private methods
+
+    void Engine::quit_handler_(event::Event& event)
+    {
+        quit_ = true;
+    }
+
+    void Engine::resize_handler_(event::Event& event)
+    {
+        assert(graphics_manager_);
+
+        event::ResizeEvent resize = event.get<event::ResizeEvent>();
 
-        coordinator->send_event(event_id);
+        graphics_manager_->resize(resize.width, resize.height);
     }
 }
@@ -1,19 +1,20 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <ostream>
+#include <vector>
+
 #include "coordinator.hpp"
 #include "graphics_manager.hpp"
+#include "world.hpp"
+
+#include "utils_job_system.hpp"
 
 #include "event.hpp"
+#include "event_recording.hpp"
 #include "event_types.hpp"
 
-#include "gravity.hpp"
-#include "camera.hpp"
-#include "rigid_body.hpp"
-#include "transform.hpp"
-
-#include "camera_control_system.hpp"
-#include "physics_system.hpp"
-
 namespace engine
 {
     class Engine
@@ -28,5 +29,35 @@ namespace engine
             bool should_quit();
             void send_event(event::Event& event);
             void send_event(event::EventId event_id);
+            // Queues an event, delivered at the start of the next update. Safe to
+            // call from any thread, e.g. an input thread; false if it was dropped
+            bool post_event(event::Event const& event);
+            // Debug: the system schedule of the last frame with per-system timings
+            void dump_schedule(std::ostream& stream);
+            // Writes / replaces the entities and components of the world
+            bool save_world(const std::string& path);
+            bool load_world(const std::string& path);
+            // Records the events sent and posted to the engine, and the dt of
+            // every update, until stopped - for replays by the headless runner.
+            // Start and stop from the thread updating the engine; other threads
+            // may keep posting meanwhile.
+            void start_recording();
+            bool stop_recording(const std::string& path);
+        private:
+            void quit_handler_(event::Event& event);
+            void resize_handler_(event::Event& event);
+
+            std::unique_ptr<utils::JobSystem> job_system_{};
+            std::unique_ptr<World> world_{};
+            // Subscriptions to the world events, released before the world
+            std::vector<event::EventListener> event_listeners_{};
+            std::unique_ptr<graphics::GraphicsManager> graphics_manager_{};
+            // The recording in progress, if any, read by the threads posting
+            // events. It points into recorder_, which is kept until shutdown, so
+            // a post racing with stop_recording never finds it freed.
+            std::atomic<event::EventRecording*> recording_{nullptr};
+            std::unique_ptr<event::EventRecording> recorder_{};
+
+            bool quit_ = false;
     };
 }
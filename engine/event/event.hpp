@@ -1,7 +1,10 @@
 #pragma once
 
-#include <any>
-#include <unordered_map>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
 
 #include "event_types.hpp"
 
@@ -9,34 +12,64 @@ namespace engine
 {
     namespace event
     {
+        // An event type and its payload (see event_types.hpp), stored inline:
+        // creating, copying or sending an event never allocates.
+        //
+        //     Event event(MousePositionEvent { x, y });
+        //     MousePositionEvent position = event.get<MousePositionEvent>();
         class Event
         {
             public:
+                static constexpr std::size_t PAYLOAD_SIZE = 32;
+
                 Event() = delete;
 
+                // An event without payload
                 explicit Event(EventId type): type_(type)
                 {}
 
                 template<typename T>
-                void set_parameter(EventId id, T value)
+                explicit Event(T const& payload): type_(T::ID)
+                {
+                    static_assert(std::is_trivially_copyable<T>::value, "Event payloads must be trivially copyable.");
+                    static_assert(sizeof(T) <= PAYLOAD_SIZE, "Event payload too large.");
+
+                    std::memcpy(payload_, &payload, sizeof(T));
+                }
+
+                // An event from a raw payload, as written by get_payload (recordings)
+                Event(EventId type, std::byte const* payload, std::size_t size): type_(type)
                 {
-                    data_[id] = value;
+                    assert(size <= PAYLOAD_SIZE && "Event payload too large.");
+
+                    std::memcpy(payload_, payload, size);
                 }
 
                 template<typename T>
-                T get_parameter(EventId id)
+                T get() const
                 {
-                    return std::any_cast<T>(data_[id]);
+                    assert(type_ == T::ID && "Event payload of another type.");
+
+                    T payload;
+                    std::memcpy(&payload, payload_, sizeof(T));
+
+                    return payload;
                 }
 
                 EventId get_type() const
                 {
                     return type_;
                 }
-                
+
+                // The PAYLOAD_SIZE raw bytes, zero past the payload
+                std::byte const* get_payload() const
+                {
+                    return payload_;
+                }
+
             private:
                 EventId type_{};
-                std::unordered_map<EventId, std::any> data_{};
+                alignas(std::max_align_t) std::byte payload_[PAYLOAD_SIZE]{};
         };
     }
-}
\ No newline at end of file
+}
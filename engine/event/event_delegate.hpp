@@ -0,0 +1,68 @@
+#pragma once
+
+#include "event.hpp"
+
+namespace engine
+{
+    namespace event
+    {
+        // A listener as two pointers: the object and a thunk calling the bound
+        // method (or a free function) on it. Trivially copyable, never allocates,
+        // and comparable - so a listener can be found again to unsubscribe it.
+        //
+        //     EventDelegate::bind<&System::input_handler_>(this);
+        //     EventDelegate::bind<&on_quit>();
+        class EventDelegate
+        {
+            public:
+                EventDelegate() = default;
+
+                template<auto Method, typename C>
+                static EventDelegate bind(C* object)
+                {
+                    return EventDelegate(object, [](void* object, Event& event)
+                    {
+                        (static_cast<C*>(object)->*Method)(event);
+                    });
+                }
+
+                template<auto Function>
+                static EventDelegate bind()
+                {
+                    return EventDelegate(nullptr, [](void*, Event& event)
+                    {
+                        Function(event);
+                    });
+                }
+
+                void operator()(Event& event) const
+                {
+                    call_(object_, event);
+                }
+
+                explicit operator bool() const
+                {
+                    return call_ != nullptr;
+                }
+
+                bool operator==(EventDelegate const& other) const
+                {
+                    return object_ == other.object_ && call_ == other.call_;
+                }
+
+                bool operator!=(EventDelegate const& other) const
+                {
+                    return !(*this == other);
+                }
+
+            private:
+                using Call = void (*)(void* object, Event& event);
+
+                EventDelegate(void* object, Call call): object_(object), call_(call)
+                {}
+
+                void* object_ = nullptr;
+                Call call_ = nullptr;
+        };
+    }
+}
@@ -1,41 +1,332 @@
 #pragma once
 
-#include <functional>
-#include <list>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "event_types.hpp"
 #include "event.hpp"
+#include "event_delegate.hpp"
+
+#include "utils_mpsc_ring.hpp"
 
 namespace engine
 {
     namespace event
     {
+        class EventManager;
+
+        // A subscription: unsubscribes its listener when destroyed or reset.
+        // Move-only. It may outlive the manager it was returned by, which then
+        // leaves it unsubscribed.
+        class [[nodiscard]] EventListener
+        {
+            public:
+                EventListener() = default;
+
+                // manager points to the manager while it exists, null afterwards
+                EventListener(std::shared_ptr<EventManager*> manager, EventId type, EventDelegate delegate)
+                    : manager_(std::move(manager)), type_(type), delegate_(delegate)
+                {}
+
+                ~EventListener()
+                {
+                    reset();
+                }
+
+                EventListener(EventListener&& other) noexcept
+                    : manager_(std::move(other.manager_)), type_(other.type_), delegate_(other.delegate_)
+                {}
+
+                EventListener& operator=(EventListener&& other) noexcept
+                {
+                    if (this != &other)
+                    {
+                        reset();
+
+                        manager_ = std::move(other.manager_);
+                        type_ = other.type_;
+                        delegate_ = other.delegate_;
+                    }
+
+                    return *this;
+                }
+
+                EventListener(EventListener const&) = delete;
+                EventListener& operator=(EventListener const&) = delete;
+
+                // Unsubscribes now
+                inline void reset();
+
+                bool is_subscribed() const
+                {
+                    return manager_ && *manager_;
+                }
+
+            private:
+                std::shared_ptr<EventManager*> manager_{};
+                EventId type_{};
+                EventDelegate delegate_{};
+        };
+
+        // Delivers events to the listeners of their type, either right away
+        // (send_event) or queued until the next dispatch_events (post_event).
+        // Queued events of a coalesced type are merged: a frame delivers at most
+        // one of them, holding the latest or the summed payload.
+        // Only post_event may be called from other threads than the one owning
+        // the manager.
         class EventManager
         {
             public:
-                void add_listener(EventId eventId, std::function<void(Event&)> const& listener)
+                EventManager() = default;
+
+                // Outstanding handles find the manager gone
+                ~EventManager()
+                {
+                    *self_ = nullptr;
+                }
+
+                // Handles point to it: it stays where it was created
+                EventManager(EventManager const&) = delete;
+                EventManager& operator=(EventManager const&) = delete;
+
+                // Subscribes the listener until the returned handle goes away.
+                // A listener subscribes to a type once: subscribing it again is
+                // a bug, reported by an assert, and returns an empty handle.
+                EventListener add_listener(EventId event_id, EventDelegate listener)
+                {
+                    assert(listener && "Empty event listener.");
+
+                    std::vector<EventDelegate>& listeners = listeners_[event_id];
+
+                    if (std::find(listeners.begin(), listeners.end(), listener) != listeners.end())
+                    {
+                        assert(false && "Listener already subscribed to this event.");
+                        return {};
+                    }
+
+                    listeners.push_back(listener);
+
+                    return EventListener(self_, event_id, listener);
+                }
+
+                // Called by EventListener
+                void remove_listener(EventId event_id, EventDelegate listener)
                 {
-                    listeners_[eventId].push_back(listener);
+                    auto it = listeners_.find(event_id);
+                    if (it == listeners_.end())
+                        return;
+
+                    std::vector<EventDelegate>& listeners = it->second;
+
+                    auto position = std::find(listeners.begin(), listeners.end(), listener);
+                    if (position == listeners.end())
+                        return;
+
+                    // While sending, only blank the slot: the send loops index the
+                    // array, and it is compacted once the outermost send returns
+                    if (sending_ > 0)
+                    {
+                        *position = EventDelegate();
+                        has_removed_ = true;
+                    }
+                    else
+                    {
+                        listeners.erase(position);
+                    }
                 }
 
                 void send_event(Event& event)
                 {
-                    uint32_t type = event.get_type();
+                    // Looked up without inserting, so events nobody listens to cost nothing
+                    auto it = listeners_.find(event.get_type());
+                    if (it == listeners_.end())
+                        return;
+
+                    std::vector<EventDelegate>& listeners = it->second;
+
+                    // Listeners may subscribe or unsubscribe others: index, and
+                    // skip the ones subscribed during this send
+                    ++sending_;
 
-                    for (auto const& listener : listeners_[type])
-                        listener(event);
+                    for (std::size_t i = 0, count = listeners.size(); i < count; ++i)
+                    {
+                        EventDelegate listener = listeners[i];
+                        if (listener)
+                            listener(event);
+                    }
+
+                    if (--sending_ == 0 && has_removed_)
+                        compact_();
                 }
 
                 void send_event(EventId event_id)
                 {
                     Event event(event_id);
+                    send_event(event);
+                }
 
-                    for (auto const& listener : listeners_[event_id])
-                        listener(event);
+                // Queued events of type T are merged down to the latest one
+                template<typename T>
+                void coalesce_replace()
+                {
+                    set_merge_(T::ID, [](Event& queued, Event const& event)
+                    {
+                        queued = event;
+                    });
                 }
+
+                // Queued events of type T are merged by summing their payloads with
+                // +=, for deltas
+                template<typename T>
+                void coalesce_accumulate()
+                {
+                    set_merge_(T::ID, [](Event& queued, Event const& event)
+                    {
+                        T sum = queued.get<T>();
+                        sum += event.get<T>();
+
+                        queued = Event(sum);
+                    });
+                }
+
+                // Queues an event until the next dispatch_events. Safe to call from any
+                // thread, without locking. Returns false, dropping the event, if
+                // POST_CAPACITY events are already waiting.
+                bool post_event(Event const& event)
+                {
+                    return posted_.try_push(event);
+                }
+
+                // Takes the events posted so far into the next dispatch; the ones
+                // posted afterwards wait for the dispatch after it. Only needed to
+                // cut the frame at a precise point - dispatch_events collects them
+                // itself otherwise.
+                void collect_events()
+                {
+                    posted_.drain([this](Event& event)
+                    {
+                        enqueue_(event);
+                    });
+
+                    collected_ = true;
+                }
+
+                // Sends the queued events in the order they were first posted.
+                // Events posted meanwhile by the listeners wait for the next dispatch.
+                void dispatch_events()
+                {
+                    if (!collected_)
+                        collect_events();
+
+                    collected_ = false;
+
+                    for (auto& coalesced : coalesced_)
+                        coalesced.queued = NOT_QUEUED;
+
+                    for (Event& event : queue_)
+                        send_event(event);
+
+                    // Keep the capacity: a steady frame queue does not allocate
+                    queue_.clear();
+                }
+
+                static constexpr std::size_t POST_CAPACITY = 4096;
+
             private:
-                std::unordered_map<EventId, std::list<std::function<void(Event&)>>> listeners_;
+                static constexpr std::size_t NOT_QUEUED = ~std::size_t(0);
+
+                using Merge = void (*)(Event& queued, Event const& event);
+
+                struct Coalesced
+                {
+                    EventId type;
+                    Merge merge;
+                    // Position of the pending event of the type in the queue
+                    std::size_t queued;
+                };
+
+                // Appends a posted event to the frame queue, or merges it into the
+                // queued event of the same type if its type is coalesced
+                void enqueue_(Event const& event)
+                {
+                    for (auto& coalesced : coalesced_)
+                    {
+                        if (coalesced.type != event.get_type())
+                            continue;
+
+                        if (coalesced.queued != NOT_QUEUED)
+                        {
+                            coalesced.merge(queue_[coalesced.queued], event);
+                            return;
+                        }
+
+                        coalesced.queued = queue_.size();
+                        break;
+                    }
+
+                    queue_.push_back(event);
+                }
+
+                void compact_()
+                {
+                    for (auto& [type, listeners] : listeners_)
+                    {
+                        listeners.erase(
+                            std::remove(listeners.begin(), listeners.end(), EventDelegate()),
+                            listeners.end()
+                        );
+                    }
+
+                    has_removed_ = false;
+                }
+
+                void set_merge_(EventId type, Merge merge)
+                {
+                    for (auto& coalesced : coalesced_)
+                    {
+                        if (coalesced.type == type)
+                        {
+                            coalesced.merge = merge;
+                            return;
+                        }
+                    }
+
+                    coalesced_.push_back({ type, merge, NOT_QUEUED });
+                }
+
+                // Shared with the handles, cleared when the manager goes away
+                std::shared_ptr<EventManager*> self_ = std::make_shared<EventManager*>(this);
+
+                // Per event type, the listeners in subscription order
+                std::unordered_map<EventId, std::vector<EventDelegate>> listeners_;
+
+                // Nesting depth of send_event, listeners sending events themselves
+                std::size_t sending_ = 0;
+                bool has_removed_ = false;
+
+                // Events posted since the last dispatch, from any thread
+                utils::MPSCRing<Event> posted_{POST_CAPACITY};
+
+                // Posted events once merged, being dispatched
+                std::vector<Event> queue_{};
+                // collect_events ran since the last dispatch
+                bool collected_ = false;
+
+                // Coalesced event types - a handful, scanned linearly
+                std::vector<Coalesced> coalesced_{};
         };
+
+        void EventListener::reset()
+        {
+            if (is_subscribed())
+                (*manager_)->remove_listener(type_, delegate_);
+
+            manager_.reset();
+        }
     }
-}
\ No newline at end of file
+}
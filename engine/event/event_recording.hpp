@@ -0,0 +1,291 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "event.hpp"
+
+namespace engine
+{
+    namespace event
+    {
+        // The events fed to an engine, frame by frame, with the timestep of every
+        // frame - enough to replay a session without its window and its input.
+        //
+        // Binary format (native endianness): a header, then per frame its dt and
+        // event count, then the events in order, each as its type, how it was
+        // delivered and its payload without the trailing zero bytes.
+        class EventRecording
+        {
+            public:
+                static constexpr char MAGIC[8] = { 'E', 'V', 'T', 'R', 'E', 'C', '\0', '\0' };
+                static constexpr std::uint32_t FORMAT_VERSION = 1;
+
+                // Replayed with send_event or post_event, like it was recorded
+                enum class Delivery : std::uint8_t
+                {
+                    SENT,
+                    POSTED
+                };
+
+                // Any thread
+                void record(Event const& event, Delivery delivery)
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+
+                    events_.push_back({ event, delivery });
+                }
+
+                // Any thread. Records the event, then delivers it with deliver(),
+                // returning false if it was dropped - and dropping the record too.
+                // Both happen under the lock end_frame takes, so with the close
+                // step of end_frame the event lands in the frame delivering it.
+                template<typename F>
+                bool record(Event const& event, Delivery delivery, F&& deliver)
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+
+                    events_.push_back({ event, delivery });
+
+                    if (deliver())
+                        return true;
+
+                    events_.pop_back();
+
+                    return false;
+                }
+
+                // Forgets every frame and event
+                void clear()
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+
+                    frames_.clear();
+                    frame_starts_.clear();
+                    events_.clear();
+                    closed_events_ = 0;
+                }
+
+                // Closes a frame: the events recorded since the previous frame are
+                // replayed before stepping the world by dt
+                void end_frame(float dt)
+                {
+                    end_frame(dt, []() {});
+                }
+
+                // end_frame, then close() under the same lock as the recording of
+                // events: e.g. collecting the posted events for the step, so none
+                // recorded in the next frame is delivered by this one
+                template<typename F>
+                void end_frame(float dt, F&& close)
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+
+                    frames_.push_back({ dt, static_cast<std::uint32_t>(events_.size() - closed_events_) });
+                    frame_starts_.push_back(closed_events_);
+                    closed_events_ = events_.size();
+
+                    close();
+                }
+
+                std::size_t get_frame_count() const
+                {
+                    return frames_.size();
+                }
+
+                float get_dt(std::size_t frame) const
+                {
+                    assert(frame < frames_.size() && "Frame out of range.");
+
+                    return frames_[frame].dt;
+                }
+
+                // Calls fn(Event const&, Delivery) for the events of the frame, in
+                // order. Not while recording from other threads.
+                template<typename F>
+                void each_event(std::size_t frame, F&& fn) const
+                {
+                    assert(frame < frames_.size() && "Frame out of range.");
+
+                    std::size_t first = frame_starts_[frame];
+                    for (std::size_t i = first; i < first + frames_[frame].event_count; ++i)
+                        fn(events_[i].event, events_[i].delivery);
+                }
+
+                // Appends the closed frames to out
+                void write(std::vector<std::byte>& out) const
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+
+                    Header header{};
+                    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+                    header.format_version = FORMAT_VERSION;
+                    header.frame_count = static_cast<std::uint32_t>(frames_.size());
+                    header.event_count = static_cast<std::uint32_t>(closed_events_);
+
+                    append_(out, &header, sizeof(Header));
+                    append_(out, frames_.data(), frames_.size() * sizeof(Frame));
+
+                    for (std::size_t i = 0; i < closed_events_; ++i)
+                    {
+                        std::byte const* payload = events_[i].event.get_payload();
+
+                        std::uint8_t size = Event::PAYLOAD_SIZE;
+                        while (size > 0 && payload[size - 1] == std::byte{0})
+                            --size;
+
+                        EventHeader event_header{ events_[i].event.get_type(), events_[i].delivery, size };
+                        append_(out, &event_header, sizeof(EventHeader));
+                        append_(out, payload, size);
+                    }
+                }
+
+                // Replaces the recording. Returns false, leaving it untouched, if the
+                // data is not a valid recording.
+                bool read(std::byte const* data, std::size_t size)
+                {
+                    std::size_t offset = 0;
+
+                    Header header;
+                    if (!read_(data, size, offset, &header, sizeof(Header)))
+                        return false;
+
+                    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.format_version != FORMAT_VERSION)
+                        return false;
+
+                    if (std::uint64_t(header.frame_count) * sizeof(Frame) > size - offset)
+                        return false;
+
+                    std::vector<Frame> frames(header.frame_count);
+                    read_(data, size, offset, frames.data(), frames.size() * sizeof(Frame));
+
+                    std::vector<std::size_t> frame_starts(frames.size());
+
+                    std::uint64_t frame_events = 0;
+                    for (std::size_t i = 0; i < frames.size(); ++i)
+                    {
+                        frame_starts[i] = frame_events;
+                        frame_events += frames[i].event_count;
+                    }
+
+                    if (frame_events != header.event_count)
+                        return false;
+
+                    std::vector<Recorded> events;
+                    events.reserve(header.event_count);
+
+                    for (std::uint32_t i = 0; i < header.event_count; ++i)
+                    {
+                        EventHeader event_header;
+                        if (!read_(data, size, offset, &event_header, sizeof(EventHeader))
+                            || event_header.size > Event::PAYLOAD_SIZE
+                            || event_header.size > size - offset)
+                            return false;
+
+                        events.push_back({ Event(event_header.type, data + offset, event_header.size), event_header.delivery });
+                        offset += event_header.size;
+                    }
+
+                    std::lock_guard<std::mutex> lock(mutex_);
+
+                    frames_ = std::move(frames);
+                    events_ = std::move(events);
+                    frame_starts_ = std::move(frame_starts);
+                    closed_events_ = events_.size();
+
+                    return true;
+                }
+
+                bool save(std::string const& path) const
+                {
+                    std::vector<std::byte> data;
+                    write(data);
+
+                    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+                    file.write(reinterpret_cast<char const*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+                    return static_cast<bool>(file);
+                }
+
+                bool load(std::string const& path)
+                {
+                    std::ifstream file(path, std::ios::binary);
+                    if (!file)
+                        return false;
+
+                    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+                    return read(reinterpret_cast<std::byte const*>(data.data()), data.size());
+                }
+
+            private:
+                #pragma pack(push, 1)
+                struct Header
+                {
+                    char magic[8];
+                    std::uint32_t format_version;
+                    std::uint32_t frame_count;
+                    std::uint32_t event_count;
+                };
+
+                struct Frame
+                {
+                    float dt;
+                    std::uint32_t event_count;
+                };
+
+                struct EventHeader
+                {
+                    EventId type;
+                    Delivery delivery;
+                    std::uint8_t size;
+                };
+                #pragma pack(pop)
+
+                struct Recorded
+                {
+                    Event event;
+                    Delivery delivery;
+                };
+
+                static void append_(std::vector<std::byte>& out, void const* data, std::size_t size)
+                {
+                    std::size_t offset = out.size();
+                    out.resize(offset + size);
+
+                    if (size > 0)
+                        std::memcpy(out.data() + offset, data, size);
+                }
+
+                static bool read_(std::byte const* data, std::size_t size, std::size_t& offset, void* out, std::size_t count)
+                {
+                    if (count > size - offset)
+                        return false;
+
+                    if (count > 0)
+                        std::memcpy(out, data + offset, count);
+
+                    offset += count;
+
+                    return true;
+                }
+
+                mutable std::mutex mutex_;
+
+                std::vector<Frame> frames_{};
+                // Position of the first event of every frame
+                std::vector<std::size_t> frame_starts_{};
+                std::vector<Recorded> events_{};
+                // Events belonging to a frame; the ones past it wait for end_frame
+                std::size_t closed_events_ = 0;
+        };
+    }
+}
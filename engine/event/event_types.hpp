@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstdint>
+
 #include "utils_hash.hpp"
+#include "utils_types.hpp"
 
 namespace engine
 {
@@ -9,12 +12,11 @@ namespace engine
         /// MARK: - Event types
 
         using EventId = std::uint32_t;
-        using EventParameterId = std::uint32_t;
 
         /// MARK: - Event listener macros
 
-        #define EVENT_METHOD_LISTENER(EventType, Listener) EventType, std::bind(&Listener, this, std::placeholders::_1)
-        #define EVENT_FUNCTION_LISTENER(EventType, Listener) EventType, std::bind(&Listener, std::placeholders::_1)
+        #define EVENT_METHOD_LISTENER(EventType, Listener) EventType, engine::event::EventDelegate::bind<&Listener>(this)
+        #define EVENT_FUNCTION_LISTENER(EventType, Listener) EventType, engine::event::EventDelegate::bind<&Listener>()
 
         /// MARK: - Events
 
@@ -25,36 +27,63 @@ namespace engine
         const EventId SCROLL_OFFSET = "events::scroll_offset"_hash;
         const EventId CAMERA_ANGLES = "events::camera_angles"_hash;
 
-        /// MARK: - Event parameters
+        /// MARK: - Event payloads
+
+        // Trivially copyable structs stored inline in the events, naming their
+        // event type with a compile-time ID
 
-        namespace resize
+        struct QuitEvent
         {
-            const EventParameterId WIDTH = "event::resize::width"_hash;
-            const EventParameterId HEIGHT = "event::resize::height"_hash;
-        }
+            static constexpr EventId ID = QUIT;
+        };
 
-        namespace input
+        struct ResizeEvent
         {
-            const EventParameterId PARAMETER = "event::input::parameter"_hash;
-        }
+            static constexpr EventId ID = RESIZE;
+
+            int width;
+            int height;
+        };
 
-        namespace mouse_position
+        struct InputEvent
         {
-            const EventParameterId X = "event::mouse_position::x"_hash;
-            const EventParameterId Y = "event::mouse_position::y"_hash;
-        }
+            static constexpr EventId ID = INPUT;
 
-        namespace scroll_offset
+            Input input;
+        };
+
+        struct MousePositionEvent
         {
-            const EventParameterId X = "event::scroll_offset::x"_hash;
-            const EventParameterId Y = "event::scroll_offset::y"_hash;
-        }
+            static constexpr EventId ID = MOUSE_POSITION;
+
+            double x;
+            double y;
+        };
 
-        namespace camera_angles
+        struct ScrollOffsetEvent
         {
-            const EventParameterId PITCH = "event::camera_angles::pitch"_hash;
-            const EventParameterId YAW = "event::camera_angles::yaw"_hash;
-            const EventParameterId ROLL = "event::camera_angles::roll"_hash;
-        }
+            static constexpr EventId ID = SCROLL_OFFSET;
+
+            double x;
+            double y;
+
+            // Scroll offsets are deltas: coalesced events add up
+            ScrollOffsetEvent& operator+=(ScrollOffsetEvent const& other)
+            {
+                x += other.x;
+                y += other.y;
+
+                return *this;
+            }
+        };
+
+        struct CameraAnglesEvent
+        {
+            static constexpr EventId ID = CAMERA_ANGLES;
+
+            double pitch;
+            double yaw;
+            double roll;
+        };
     }
 }
\ No newline at end of file
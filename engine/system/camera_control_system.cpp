@@ -2,31 +2,34 @@
 
 namespace engine
 {
-    extern std::shared_ptr<Coordinator> coordinator;
-
     namespace system
     {
-        void CameraControlSystem::init()
+        CameraControlSystem::CameraControlSystem(Coordinator& coordinator)
+            : coordinator_(&coordinator)
         {
-            assert(coordinator);
+            writes<component::Camera, component::Transform>();
+        }
 
-            coordinator->add_event_listener(EVENT_METHOD_LISTENER(event::INPUT, CameraControlSystem::input_handler_));
-            coordinator->add_event_listener(EVENT_METHOD_LISTENER(event::MOUSE_POSITION, CameraControlSystem::mouse_position_handler_));
-            coordinator->add_event_listener(EVENT_METHOD_LISTENER(event::CAMERA_ANGLES, CameraControlSystem::camera_angles_handler_));
+        void CameraControlSystem::init()
+        {
+            event_listeners_.push_back(coordinator_->add_event_listener(EVENT_METHOD_LISTENER(event::INPUT, CameraControlSystem::input_handler_)));
+            event_listeners_.push_back(coordinator_->add_event_listener(EVENT_METHOD_LISTENER(event::MOUSE_POSITION, CameraControlSystem::mouse_position_handler_)));
+            event_listeners_.push_back(coordinator_->add_event_listener(EVENT_METHOD_LISTENER(event::CAMERA_ANGLES, CameraControlSystem::camera_angles_handler_)));
 
             // Create default camera
 
-            selected_ = coordinator->create_entity();
+            ecs::ECSEntity camera = coordinator_->create_entity();
+            coordinator_->set_resource(component::ActiveCamera { camera });
 
-            coordinator->add_component(
-                selected_,
+            coordinator_->add_component(
+                camera,
                 component::Transform {
                     .position = Diligent::float3(0, 0, -5)
                 }
             );
 
-            coordinator->add_component(
-                selected_,
+            coordinator_->add_component(
+                camera,
                 component::Camera {
                     .yaw = 0,
                     .pitch = 0,
@@ -34,15 +37,15 @@ namespace engine
                 }
             );
 
-            coordinator->add_component(
-                selected_,
+            coordinator_->add_component(
+                camera,
                 component::Gravity {
                     .force = Diligent::float3(0, -9.81, 0)
                 }
             );
 
-            coordinator->add_component(
-                selected_,
+            coordinator_->add_component(
+                camera,
                 component::RigidBody {
                     .velocity = Diligent::float3(0),
                     .acceleration = Diligent::float3(0)
@@ -63,8 +66,8 @@ namespace engine
 
         Diligent::float4x4 CameraControlSystem::look_at()
         {
-            auto& camera = coordinator->get_component<component::Camera>(selected_);
-            auto& transform = coordinator->get_component<component::Transform>(selected_);
+            auto& camera = coordinator_->get_component<component::Camera>(selected_());
+            auto& transform = coordinator_->get_component<component::Transform>(selected_());
 
             Diligent::float3 z_axis = camera.direction;
             Diligent::float3 x_axis = normalize(cross(up_axis_, z_axis));
@@ -84,43 +87,50 @@ namespace engine
 
         Diligent::float3 CameraControlSystem::get_position()
         {
-            auto& transform = coordinator->get_component<component::Transform>(selected_);
+            auto& transform = coordinator_->get_component<component::Transform>(selected_());
 
             return transform.position;
         }
 
         // MARK: - Private methods
 
+        ecs::ECSEntity CameraControlSystem::selected_() const
+        {
+            return coordinator_->get_resource<component::ActiveCamera>().entity;
+        }
+
         void CameraControlSystem::move_from_keyboard_input_(float dt)
         {
-            assert(coordinator);
+            auto& camera = coordinator_->get_component<component::Camera>(selected_());
+            auto& transform = coordinator_->get_component<component::Transform>(selected_());
 
-            auto& camera = coordinator->get_component<component::Camera>(selected_);
-            auto& transform = coordinator->get_component<component::Transform>(selected_);
+            Input const& input = coordinator_->get_resource<Input>();
 
-            double speed_up_scale = (input_.speed_up ? 2.0 : 1.0);
+            double speed_up_scale = (input.speed_up ? 2.0 : 1.0);
 
-            if (input_.forward)
+            if (input.forward)
                 transform.position += camera.direction * move_velocity_ * dt * speed_up_scale;
 
-            if (input_.backward)
+            if (input.backward)
                 transform.position -= camera.direction * move_velocity_ * dt * speed_up_scale;
 
-            if (input_.left)
+            if (input.left)
                 transform.position += normalize(cross(camera.direction, up_axis_)) * dt * move_velocity_ * speed_up_scale;
 
-            if (input_.right)
+            if (input.right)
                 transform.position -= normalize(cross(camera.direction, up_axis_)) * dt * move_velocity_ * speed_up_scale;
 
-            if (input_.up)
+            if (input.up)
                 transform.position.y += move_velocity_ * dt * speed_up_scale;
+
+            // Written through get_component: record it for change tracking
+            if (input.forward || input.backward || input.left || input.right || input.up)
+                coordinator_->mark_changed<component::Transform>(selected_());
         }
 
         void CameraControlSystem::orientate_with_mouse_()
         {
-            assert(coordinator);
-
-            auto& camera = coordinator->get_component<component::Camera>(selected_);
+            auto& camera = coordinator_->get_component<component::Camera>(selected_());
 
             if (first_mouse_)
             {
@@ -138,14 +148,14 @@ namespace engine
 
             camera.yaw += x_offset;
             camera.pitch += y_offset;
+
+            coordinator_->mark_changed<component::Camera>(selected_());
         }
 
         /// https://learnopengl.com/Getting-started/Camera
         void CameraControlSystem::update_direction_()
         {
-            assert(coordinator);
-
-            auto& camera = coordinator->get_component<component::Camera>(selected_);
+            auto& camera = coordinator_->get_component<component::Camera>(selected_());
 
             camera.pitch = utils::clamp(camera.pitch, -89, 89);
 
@@ -157,32 +167,33 @@ namespace engine
             camera.direction.z = sin(yaw_radian) * cos(pitch_radian);
 
             camera.direction = normalize(camera.direction);
+
+            coordinator_->mark_changed<component::Camera>(selected_());
         }
 
         void CameraControlSystem::input_handler_(event::Event& event)
         {
-            input_ = event.get_parameter<Input>(event::input::PARAMETER);
+            coordinator_->get_resource<Input>() = event.get<event::InputEvent>().input;
         }
 
         void CameraControlSystem::mouse_position_handler_(event::Event& event)
         {
-            double x = event.get_parameter<double>(engine::event::mouse_position::X);
-	        double y = event.get_parameter<double>(engine::event::mouse_position::Y);
+            event::MousePositionEvent position = event.get<event::MousePositionEvent>();
 
-            mouse_position_ = Diligent::float2(x, y);
+            mouse_position_ = Diligent::float2(position.x, position.y);
         }
 
         void CameraControlSystem::camera_angles_handler_(event::Event& event)
         {
-            double pitch = event.get_parameter<double>(engine::event::camera_angles::PITCH);
-	        double yaw = event.get_parameter<double>(engine::event::camera_angles::YAW);
-            double roll = event.get_parameter<double>(engine::event::camera_angles::ROLL);
+            event::CameraAnglesEvent angles = event.get<event::CameraAnglesEvent>();
+
+            auto& camera = coordinator_->get_component<component::Camera>(selected_());
 
-            auto& camera = coordinator->get_component<component::Camera>(selected_);
+            camera.yaw = angles.yaw;
+            camera.pitch = angles.pitch;
+            camera.roll = angles.roll;
 
-            camera.yaw = yaw;
-            camera.pitch = pitch; 
-            camera.roll = roll; 
+            coordinator_->mark_changed<component::Camera>(selected_());
         }
     }
 }
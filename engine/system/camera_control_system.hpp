@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include "coordinator.hpp"
 #include "ecs_system.hpp"
 
@@ -9,6 +11,7 @@
 #include "utils_maths.hpp"
 #include "utils_types.hpp"
 
+#include "active_camera.hpp"
 #include "transform.hpp"
 #include "camera.hpp"
 #include "rigid_body.hpp"
@@ -21,8 +24,10 @@ namespace engine
         class CameraControlSystem : public ecs::ECSSystem
         {
             public:
+                explicit CameraControlSystem(Coordinator& coordinator);
+
                 void init();
-                void update(float dt);
+                void update(float dt) override;
                 Diligent::float4x4 look_at();
                 Diligent::float3 get_position();
             private:
@@ -32,10 +37,10 @@ namespace engine
                 void input_handler_(event::Event& event);
                 void mouse_position_handler_(event::Event& event);
                 void camera_angles_handler_(event::Event& event);
+                ecs::ECSEntity selected_() const;
 
-                Input input_;
-
-                ecs::ECSEntity selected_;
+                Coordinator* coordinator_;
+                std::vector<event::EventListener> event_listeners_{};
 
                 /// MacOS only: Internal mouse logic
                 bool first_mouse_ = true;
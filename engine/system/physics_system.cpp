@@ -2,35 +2,63 @@
 
 namespace engine
 {
-    extern std::shared_ptr<Coordinator> coordinator;
-
     namespace system
     {
-        void PhysicsSystem::update(float dt)
+        PhysicsSystem::PhysicsSystem(Coordinator& coordinator, utils::JobSystem* job_system)
+            : coordinator_(&coordinator), job_system_(job_system)
         {
-            assert(coordinator);
+            reads<component::Gravity>();
+            writes<component::Transform, component::RigidBody>();
+        }
 
-            coordinator->add_event_listener(EVENT_METHOD_LISTENER(event::INPUT, PhysicsSystem::input_handler_));
+        void PhysicsSystem::init()
+        {
+            input_listener_ = coordinator_->add_event_listener(EVENT_METHOD_LISTENER(event::INPUT, PhysicsSystem::input_handler_));
 
-            if (gravity_enabled_)
+            if (coordinator_->get_storage_mode() == ecs::ECSStorageMode::SPARSE_SET)
+                query_ = ecs::ECSQuery(coordinator_->view<component::Transform, component::RigidBody, const component::Gravity>());
+        }
+
+        void PhysicsSystem::update(float dt)
+        {
+            if (!gravity_enabled_)
+                return;
+
+            // Archetype storage: stream through the matching chunks linearly
+            if (coordinator_->get_storage_mode() == ecs::ECSStorageMode::ARCHETYPE)
             {
-                for (auto const& entity : entities_)
-                {
-                    auto& rigid_body = coordinator->get_component<component::RigidBody>(entity);
-                    auto& transform = coordinator->get_component<component::Transform>(entity);
-                    auto const& gravity = coordinator->get_component<component::Gravity>(entity);
-
-                    // Force
-                    transform.position += rigid_body.velocity * dt;
-                    rigid_body.velocity += gravity.force * dt;
-                }
+                coordinator_->each_chunk<component::Transform, component::RigidBody, const component::Gravity>(
+                    [dt](std::uint32_t count, ecs::ECSEntity const* entities, component::Transform* transforms, component::RigidBody* rigid_bodies, const component::Gravity* gravities)
+                    {
+                        for (std::uint32_t i = 0; i < count; ++i)
+                        {
+                            // Force
+                            transforms[i].position += rigid_bodies[i].velocity * dt;
+                            rigid_bodies[i].velocity += gravities[i].force * dt;
+                        }
+                    }
+                );
+
+                return;
             }
+
+            auto integrate = [dt](ecs::ECSEntity entity, component::Transform& transform, component::RigidBody& rigid_body, const component::Gravity& gravity)
+            {
+                // Force
+                transform.position += rigid_body.velocity * dt;
+                rigid_body.velocity += gravity.force * dt;
+            };
+
+            // Every body is independent: split them over the worker threads
+            if (job_system_)
+                query_.parallel_each(*job_system_, integrate);
+            else
+                query_.each(integrate);
         }
 
         void PhysicsSystem::input_handler_(event::Event& event)
         {
-            Input input = event.get_parameter<Input>(event::input::PARAMETER);
-            gravity_enabled_ = input.gravity;
+            gravity_enabled_ = event.get<event::InputEvent>().input.gravity;
         }
     }
 }
@@ -6,6 +6,7 @@
 #include "rigid_body.hpp"
 #include "gravity.hpp"
 
+#include "utils_job_system.hpp"
 #include "utils_types.hpp"
 
 #include "event.hpp"
@@ -18,10 +19,20 @@ namespace engine
         class PhysicsSystem : public ecs::ECSSystem
         {
             public:
-                void update(float dt);
+                // Bodies are integrated over the threads of the job system, if any
+                explicit PhysicsSystem(Coordinator& coordinator, utils::JobSystem* job_system = nullptr);
+
+                void init();
+                void update(float dt) override;
             private:
                 void input_handler_(event::Event& event);
 
+                Coordinator* coordinator_;
+                utils::JobSystem* job_system_;
+                event::EventListener input_listener_{};
+
+                ecs::ECSQuery<component::Transform, component::RigidBody, const component::Gravity> query_;
+
                 bool gravity_enabled_ = false;
         };
     }
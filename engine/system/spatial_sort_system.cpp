@@ -0,0 +1,211 @@
+#include "spatial_sort_system.hpp"
+
+namespace engine
+{
+    namespace system
+    {
+        SpatialSortSystem::SpatialSortSystem(Coordinator& coordinator)
+            : coordinator_(&coordinator)
+        {
+            // Reordering moves the components around: nothing else may touch them meanwhile
+            writes<component::Transform, component::RigidBody, component::Gravity>();
+        }
+
+        void SpatialSortSystem::set_budget(std::size_t budget)
+        {
+            budget_ = budget;
+        }
+
+        bool SpatialSortSystem::is_sorting() const
+        {
+            return step_ != Step::IDLE;
+        }
+
+        template<typename T>
+        void SpatialSortSystem::place_(ecs::ECSEntity entity, std::uint32_t slot)
+        {
+            // The slots before this one hold already placed members, so the entity
+            // can only be further down
+            std::uint32_t current = coordinator_->get_component_array<T>()->index_of(entity);
+
+            if (current != slot)
+                coordinator_->swap_component_slots<T>(slot, current);
+        }
+
+        void SpatialSortSystem::update(float dt)
+        {
+            // Entities added or removed: the current pass is out of date
+            if (step_ != Step::IDLE && is_stale_())
+            {
+                step_ = Step::IDLE;
+                idle_frames_ = PASS_INTERVAL;
+            }
+
+            if (step_ == Step::IDLE)
+            {
+                if (++idle_frames_ < PASS_INTERVAL)
+                    return;
+
+                start_pass_();
+            }
+
+            std::size_t visited = 0;
+            while (step_ != Step::IDLE && visited < budget_)
+                visited += advance_(budget_ - visited);
+        }
+
+        void SpatialSortSystem::start_pass_()
+        {
+            idle_frames_ = 0;
+            save_versions_();
+
+            if (entities_.size() == 0)
+                return;
+
+            count_ = entities_.size();
+            if (count_ > capacity_)
+            {
+                capacity_ = count_;
+                keys_.reset(new Key[capacity_]);
+                sorted_.reset(new Key[capacity_]);
+            }
+
+            counts_.resize(std::size_t(1) << RADIX_BITS);
+
+            min_ = coordinator_->get_component_array<component::Transform>()->get(entities_[0]).position;
+            max_ = min_;
+
+            next_step_(Step::BOUNDS);
+        }
+
+        void SpatialSortSystem::next_step_(Step step)
+        {
+            step_ = step;
+            cursor_ = 0;
+
+            if (step == Step::COUNT)
+                std::fill(counts_.begin(), counts_.end(), 0);
+        }
+
+        std::size_t SpatialSortSystem::advance_(std::size_t budget)
+        {
+            auto* transforms = coordinator_->get_component_array<component::Transform>();
+
+            std::size_t end = std::min(count_, cursor_ + budget);
+            std::size_t visited = end - cursor_;
+
+            // Positions keep moving during the pass: clamp them into the box
+            auto quantize = [](float value, float min, float max) -> std::uint32_t
+            {
+                float extent = max - min;
+                float t = extent > 0 ? (value - min) / extent : 0.0f;
+
+                return static_cast<std::uint32_t>(std::fmin(std::fmax(t, 0.0f), 1.0f) * 1023.0f);
+            };
+
+            auto digit = [this](std::uint32_t key) -> std::uint32_t
+            {
+                return (key >> (radix_pass_ * RADIX_BITS)) & ((1u << RADIX_BITS) - 1);
+            };
+
+            switch (step_)
+            {
+                case Step::BOUNDS:
+                    for (; cursor_ < end; ++cursor_)
+                    {
+                        Diligent::float3 const& position = transforms->get(entities_[cursor_]).position;
+
+                        min_ = Diligent::float3(std::fmin(min_.x, position.x), std::fmin(min_.y, position.y), std::fmin(min_.z, position.z));
+                        max_ = Diligent::float3(std::fmax(max_.x, position.x), std::fmax(max_.y, position.y), std::fmax(max_.z, position.z));
+                    }
+
+                    if (cursor_ == count_)
+                        next_step_(Step::KEYS);
+                    break;
+
+                case Step::KEYS:
+                    for (; cursor_ < end; ++cursor_)
+                    {
+                        ecs::ECSEntity entity = entities_[cursor_];
+                        Diligent::float3 const& position = transforms->get(entity).position;
+
+                        keys_[cursor_] = {
+                            utils::morton_3D(
+                                quantize(position.x, min_.x, max_.x),
+                                quantize(position.y, min_.y, max_.y),
+                                quantize(position.z, min_.z, max_.z)
+                            ),
+                            entity
+                        };
+                    }
+
+                    if (cursor_ == count_)
+                    {
+                        radix_pass_ = 0;
+                        next_step_(Step::COUNT);
+                    }
+                    break;
+
+                case Step::COUNT:
+                    for (; cursor_ < end; ++cursor_)
+                        ++counts_[digit(keys_[cursor_].key)];
+
+                    if (cursor_ == count_)
+                    {
+                        // Counts to the first position of every digit
+                        std::uint32_t position = 0;
+                        for (std::uint32_t& digit_count : counts_)
+                            position += std::exchange(digit_count, position);
+
+                        next_step_(Step::SCATTER);
+                    }
+                    break;
+
+                case Step::SCATTER:
+                    for (; cursor_ < end; ++cursor_)
+                        sorted_[counts_[digit(keys_[cursor_].key)]++] = keys_[cursor_];
+
+                    if (cursor_ == count_)
+                    {
+                        keys_.swap(sorted_);
+                        next_step_(++radix_pass_ < RADIX_PASSES ? Step::COUNT : Step::PLACE);
+                    }
+                    break;
+
+                case Step::PLACE:
+                    for (; cursor_ < end; ++cursor_)
+                    {
+                        ecs::ECSEntity entity = keys_[cursor_].entity;
+                        std::uint32_t slot = static_cast<std::uint32_t>(cursor_);
+
+                        place_<component::Transform>(entity, slot);
+                        place_<component::RigidBody>(entity, slot);
+                        place_<component::Gravity>(entity, slot);
+                    }
+
+                    if (cursor_ == count_)
+                        step_ = Step::IDLE;
+                    break;
+
+                case Step::IDLE:
+                    break;
+            }
+
+            return visited;
+        }
+
+        bool SpatialSortSystem::is_stale_() const
+        {
+            return transform_version_ != coordinator_->get_component_version<component::Transform>()
+                || rigid_body_version_ != coordinator_->get_component_version<component::RigidBody>()
+                || gravity_version_ != coordinator_->get_component_version<component::Gravity>();
+        }
+
+        void SpatialSortSystem::save_versions_()
+        {
+            transform_version_ = coordinator_->get_component_version<component::Transform>();
+            rigid_body_version_ = coordinator_->get_component_version<component::RigidBody>();
+            gravity_version_ = coordinator_->get_component_version<component::Gravity>();
+        }
+    }
+}
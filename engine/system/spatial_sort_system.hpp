@@ -0,0 +1,105 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "coordinator.hpp"
+#include "ecs_system.hpp"
+
+#include "utils_maths.hpp"
+
+#include "transform.hpp"
+#include "rigid_body.hpp"
+#include "gravity.hpp"
+
+namespace engine
+{
+    namespace system
+    {
+        // Incrementally reorders the packed arrays of the physics group
+        // (Transform, RigidBody, Gravity) along a Morton curve of the positions,
+        // so entities close in space are close in memory, and the three arrays
+        // share the same order for the entities owning all of them.
+        // A pass bounds the positions, keys the members, radix sorts the keys,
+        // then moves the members in place - every step visiting a bounded number
+        // of entities per frame. Entity handles are not affected.
+        class SpatialSortSystem : public ecs::ECSSystem
+        {
+            public:
+                explicit SpatialSortSystem(Coordinator& coordinator);
+
+                void update(float dt) override;
+
+                // Maximum number of entities a frame works on
+                void set_budget(std::size_t budget);
+
+                // True while a pass is under way
+                bool is_sorting() const;
+            private:
+                // Frames between the end of a pass and the start of the next one
+                static constexpr std::uint32_t PASS_INTERVAL = 30;
+
+                // The 30 bit keys are sorted 10 bits at a time, lowest bits first
+                static constexpr std::uint32_t RADIX_BITS = 10;
+                static constexpr std::uint32_t RADIX_PASSES = 3;
+
+                enum class Step
+                {
+                    IDLE,
+                    BOUNDS,
+                    KEYS,
+                    COUNT,
+                    SCATTER,
+                    PLACE
+                };
+
+                // Left uninitialized when allocated: the steps fill them as they go
+                struct Key
+                {
+                    std::uint32_t key;
+                    ecs::ECSEntity entity;
+                };
+
+                void start_pass_();
+                // Works on at most budget entities of the current step, returns how
+                // many it visited
+                std::size_t advance_(std::size_t budget);
+                void next_step_(Step step);
+                bool is_stale_() const;
+                void save_versions_();
+
+                // Moves an entity to a slot of the packed array of T
+                template<typename T>
+                void place_(ecs::ECSEntity entity, std::uint32_t slot);
+
+                Coordinator* coordinator_;
+
+                Step step_ = Step::IDLE;
+                // Entities visited by the current step
+                std::size_t cursor_ = 0;
+
+                // Bounding box of the positions, quantized into the keys
+                Diligent::float3 min_{};
+                Diligent::float3 max_{};
+
+                // Keys of the members, sorted one radix pass after the other
+                std::unique_ptr<Key[]> keys_;
+                std::unique_ptr<Key[]> sorted_;
+                std::size_t count_ = 0;
+                std::size_t capacity_ = 0;
+                std::vector<std::uint32_t> counts_;
+                std::uint32_t radix_pass_ = 0;
+
+                std::size_t budget_ = 4096;
+                std::uint32_t idle_frames_ = PASS_INTERVAL;
+
+                // Structural versions at the start of the pass, to detect outside changes
+                std::uint32_t transform_version_ = 0;
+                std::uint32_t rigid_body_version_ = 0;
+                std::uint32_t gravity_version_ = 0;
+        };
+    }
+}
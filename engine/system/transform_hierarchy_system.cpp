@@ -0,0 +1,217 @@
+#include "transform_hierarchy_system.hpp"
+
+namespace engine
+{
+    namespace system
+    {
+        TransformHierarchySystem::TransformHierarchySystem(Coordinator& coordinator)
+            : coordinator_(&coordinator)
+        {
+            reads<component::Transform, component::Hierarchy>();
+            writes<component::WorldTransform>();
+        }
+
+        void TransformHierarchySystem::init()
+        {
+            coordinator_->enable_change_tracking<component::Transform>();
+            coordinator_->enable_change_tracking<component::Hierarchy>();
+        }
+
+        void TransformHierarchySystem::update(float dt)
+        {
+            ecs::ECSTick since = last_tick_;
+            last_tick_ = coordinator_->advance_tick();
+
+            if (is_stale_(since))
+                rebuild_();
+            else
+                refresh_indices_();
+
+            auto* transform_array = coordinator_->get_component_array<component::Transform>();
+            auto* world_array = coordinator_->get_component_array<component::WorldTransform>();
+
+            component::Transform const* locals = transform_array->components();
+            component::WorldTransform* worlds = world_array->components();
+
+            for (std::size_t i = 0; i < order_.size(); ++i)
+            {
+                Node& node = order_[i];
+
+                // Parents come first, so their dirty flag is already known
+                bool dirty = node.fresh
+                    || transform_array->get_tick_at(node.transform) >= since
+                    || (node.parent != NO_PARENT && dirty_[node.parent]);
+
+                node.fresh = false;
+                dirty_[i] = dirty;
+
+                if (!dirty)
+                    continue;
+
+                component::Transform const& local = locals[node.transform];
+
+                Diligent::float4x4 matrix =
+                    Diligent::float4x4::Scale(local.scale)
+                    * Diligent::float4x4::RotationX(local.rotation.x)
+                    * Diligent::float4x4::RotationY(local.rotation.y)
+                    * Diligent::float4x4::RotationZ(local.rotation.z)
+                    * Diligent::float4x4::Translation(local.position);
+
+                if (node.parent != NO_PARENT)
+                    matrix = matrix * worlds[order_[node.parent].world_transform].matrix;
+
+                worlds[node.world_transform].matrix = matrix;
+                world_array->mark_changed_at(node.world_transform);
+            }
+        }
+
+        bool TransformHierarchySystem::is_stale_(ecs::ECSTick since)
+        {
+            std::uint32_t membership_version = entities_.get_version();
+            std::uint32_t hierarchy_version = coordinator_->get_component_version<component::Hierarchy>();
+
+            // Any re-parenting changes the order
+            bool reparented = false;
+            coordinator_->each_changed<component::Hierarchy>(since, [&](ecs::ECSEntity, component::Hierarchy&)
+            {
+                reparented = true;
+            });
+
+            // Transforms added or removed elsewhere only move the members' components
+            // in their arrays (see refresh_indices_)
+            bool stale = !built_
+                || reparented
+                || membership_version != membership_version_
+                || hierarchy_version != hierarchy_version_;
+
+            membership_version_ = membership_version;
+            hierarchy_version_ = hierarchy_version;
+            built_ = true;
+
+            return stale;
+        }
+
+        void TransformHierarchySystem::refresh_indices_()
+        {
+            std::uint32_t transform_version = coordinator_->get_component_order_version<component::Transform>();
+            std::uint32_t world_transform_version = coordinator_->get_component_order_version<component::WorldTransform>();
+
+            if (transform_version == transform_version_ && world_transform_version == world_transform_version_)
+                return;
+
+            transform_version_ = transform_version;
+            world_transform_version_ = world_transform_version;
+
+            auto* transforms = coordinator_->get_component_array<component::Transform>();
+            auto* world_transforms = coordinator_->get_component_array<component::WorldTransform>();
+
+            for (Node& node : order_)
+            {
+                node.transform = transforms->index_of(node.entity);
+                node.world_transform = world_transforms->index_of(node.entity);
+            }
+        }
+
+        void TransformHierarchySystem::rebuild_()
+        {
+            static constexpr std::uint32_t UNKNOWN = ~std::uint32_t(0);
+            static constexpr std::uint32_t IN_CHAIN = UNKNOWN - 1;
+
+            auto* hierarchies = coordinator_->get_component_array<component::Hierarchy>();
+            auto* transforms = coordinator_->get_component_array<component::Transform>();
+            auto* world_transforms = coordinator_->get_component_array<component::WorldTransform>();
+
+            std::size_t count = entities_.size();
+
+            // Parent of every member as a member slot, roots having none
+            std::vector<std::uint32_t> parents(count, NO_PARENT);
+            for (std::uint32_t slot = 0; slot < count; ++slot)
+            {
+                ecs::ECSEntity entity = entities_[slot];
+
+                if (!hierarchies->contains(entity))
+                    continue;
+
+                ecs::ECSEntity parent = hierarchies->get(entity).parent;
+
+                if (parent != ecs::NULL_ENTITY && entities_.contains(parent))
+                    parents[slot] = entities_.index_of(parent);
+            }
+
+            // Depth of every member, walking up to the first known ancestor
+            std::vector<std::uint32_t> depths(count, UNKNOWN);
+            std::vector<std::uint32_t> chain;
+            std::uint32_t max_depth = 0;
+
+            for (std::uint32_t slot = 0; slot < count; ++slot)
+            {
+                std::uint32_t current = slot;
+                while (current != NO_PARENT && depths[current] == UNKNOWN)
+                {
+                    depths[current] = IN_CHAIN;
+                    chain.push_back(current);
+                    current = parents[current];
+                }
+
+                // Back to an entity of this walk: a cycle. Cut the link of the
+                // topmost entity walked, which becomes a root.
+                if (current != NO_PARENT && depths[current] == IN_CHAIN)
+                {
+                    parents[chain.back()] = NO_PARENT;
+                    current = NO_PARENT;
+                }
+
+                std::uint32_t depth = current == NO_PARENT ? 0 : depths[current] + 1;
+                while (!chain.empty())
+                {
+                    depths[chain.back()] = depth++;
+                    chain.pop_back();
+                }
+
+                max_depth = std::max(max_depth, depths[slot]);
+            }
+
+            // Counting sort by depth: breadth-first order
+            std::vector<std::uint32_t> offsets(max_depth + 2, 0);
+            for (std::uint32_t depth : depths)
+                ++offsets[depth + 1];
+            for (std::size_t depth = 1; depth < offsets.size(); ++depth)
+                offsets[depth] += offsets[depth - 1];
+
+            std::vector<std::uint32_t> positions(count);
+            for (std::uint32_t slot = 0; slot < count; ++slot)
+                positions[slot] = offsets[depths[slot]]++;
+
+            order_.resize(count);
+            dirty_.assign(count, false);
+
+            for (std::uint32_t slot = 0; slot < count; ++slot)
+            {
+                ecs::ECSEntity entity = entities_[slot];
+                std::uint32_t parent = parents[slot];
+                ecs::ECSEntity parent_entity = parent == NO_PARENT ? ecs::NULL_ENTITY : entities_[parent];
+
+                // Only the entities new to the hierarchy or under a new parent need
+                // a recompute; the others keep their world transform
+                std::size_t index = ecs::entity_index(entity);
+                if (index >= links_.size())
+                    links_.resize(index + 1);
+
+                Link& link = links_[index];
+                bool fresh = link.entity != entity || link.parent != parent_entity;
+                link = { entity, parent_entity };
+
+                order_[positions[slot]] = {
+                    entity,
+                    parent == NO_PARENT ? NO_PARENT : positions[parent],
+                    transforms->index_of(entity),
+                    world_transforms->index_of(entity),
+                    fresh
+                };
+            }
+
+            transform_version_ = coordinator_->get_component_order_version<component::Transform>();
+            world_transform_version_ = coordinator_->get_component_order_version<component::WorldTransform>();
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+
+#include "coordinator.hpp"
+#include "ecs_system.hpp"
+
+#include "transform.hpp"
+#include "hierarchy.hpp"
+#include "world_transform.hpp"
+
+namespace engine
+{
+    namespace system
+    {
+        // Computes the WorldTransform of every entity owning a Transform and a
+        // WorldTransform, following Hierarchy parent links.
+        // Entities are kept sorted by depth (breadth-first), so every parent is
+        // computed before its children in one linear pass. Only the entities
+        // whose Transform changed, and their descendants, are recomputed - plus,
+        // after a change of the members or of their links, the ones joining or
+        // changing parent. A link closing a parent cycle is ignored: the entity
+        // holding it is treated as a root.
+        class TransformHierarchySystem : public ecs::ECSSystem
+        {
+            public:
+                explicit TransformHierarchySystem(Coordinator& coordinator);
+
+                void init();
+                void update(float dt) override;
+            private:
+                static constexpr std::uint32_t NO_PARENT = ~std::uint32_t(0);
+
+                struct Node
+                {
+                    ecs::ECSEntity entity;
+                    // Position of the parent in the order, or NO_PARENT for roots
+                    std::uint32_t parent;
+                    // Dense indices of the components of the entity
+                    std::uint32_t transform;
+                    std::uint32_t world_transform;
+                    // Joined the hierarchy or changed parent: recomputed next pass
+                    bool fresh;
+                };
+
+                // Parent an entity was last placed under, by entity index
+                struct Link
+                {
+                    ecs::ECSEntity entity = ecs::NULL_ENTITY;
+                    ecs::ECSEntity parent = ecs::NULL_ENTITY;
+                };
+
+                bool is_stale_(ecs::ECSTick since);
+                void rebuild_();
+                // Follows the components moved in their packed arrays
+                void refresh_indices_();
+
+                Coordinator* coordinator_;
+
+                // Members sorted by depth
+                std::vector<Node> order_;
+
+                // Recomputed this frame, parallel to order_
+                std::vector<bool> dirty_;
+
+                std::vector<Link> links_;
+
+                // Membership, versions and tick the order was built against
+                std::uint32_t membership_version_ = 0;
+                std::uint32_t transform_version_ = 0;
+                std::uint32_t world_transform_version_ = 0;
+                std::uint32_t hierarchy_version_ = 0;
+                ecs::ECSTick last_tick_ = 0;
+                bool built_ = false;
+        };
+    }
+}
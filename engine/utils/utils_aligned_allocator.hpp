@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+namespace engine
+{
+    namespace utils
+    {
+        // Cache line size assumed when laying out data shared between threads
+        const std::size_t CACHE_LINE_SIZE = 64;
+
+        // Allocator returning memory aligned on the given boundary,
+        // e.g. to start a std::vector on a cache line.
+        template<typename T, std::size_t Alignment = CACHE_LINE_SIZE>
+        class AlignedAllocator
+        {
+            public:
+                using value_type = T;
+
+                template<typename U>
+                struct rebind
+                {
+                    using other = AlignedAllocator<U, Alignment>;
+                };
+
+                AlignedAllocator() = default;
+
+                template<typename U>
+                AlignedAllocator(AlignedAllocator<U, Alignment> const&)
+                {}
+
+                T* allocate(std::size_t count)
+                {
+                    return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+                }
+
+                void deallocate(T* pointer, std::size_t)
+                {
+                    ::operator delete(pointer, std::align_val_t(Alignment));
+                }
+
+                template<typename U>
+                bool operator==(AlignedAllocator<U, Alignment> const&) const
+                {
+                    return true;
+                }
+
+                template<typename U>
+                bool operator!=(AlignedAllocator<U, Alignment> const&) const
+                {
+                    return false;
+                }
+        };
+    }
+}
\ No newline at end of file
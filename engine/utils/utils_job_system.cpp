@@ -0,0 +1,244 @@
+#include "utils_job_system.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace engine
+{
+    namespace utils
+    {
+        // Queue owned by the current thread, for the job system it works for
+        static thread_local JobSystem const* current_system = nullptr;
+        static thread_local std::size_t current_queue = 0;
+
+        /// MARK: - Public methods
+
+        JobSystem::JobSystem(std::size_t nb_workers)
+        {
+            for (std::size_t i = 0; i < nb_workers + 1; ++i)
+                queues_.push_back(std::make_unique<Queue>());
+
+            for (std::size_t i = 0; i < nb_workers; ++i)
+                threads_.emplace_back(&JobSystem::worker_loop_, this, i + 1);
+        }
+
+        JobSystem::~JobSystem()
+        {
+            {
+                std::lock_guard<std::mutex> lock(sleep_mutex_);
+                running_ = false;
+            }
+            wake_.notify_all();
+
+            for (auto& thread : threads_)
+                thread.join();
+        }
+
+        std::size_t JobSystem::default_worker_count()
+        {
+            std::size_t hardware_threads = std::thread::hardware_concurrency();
+
+            return hardware_threads > 1 ? hardware_threads - 1 : 0;
+        }
+
+        void JobSystem::schedule(Job job, JobCounter* signal, JobCounter const* dependency)
+        {
+            if (signal)
+                signal->increment();
+
+            if (dependency)
+            {
+                // Checked under the lock, which release_ takes after the counter
+                // reached zero: the job is either queued now or released later
+                std::lock_guard<std::mutex> lock(parked_mutex_);
+
+                if (!dependency->is_done())
+                {
+                    parked_.push_back({ { std::move(job), signal }, dependency });
+                    return;
+                }
+            }
+
+            push_({ std::move(job), signal });
+        }
+
+        void JobSystem::decrement(JobCounter& counter)
+        {
+            if (!counter.decrement())
+                return;
+
+            release_();
+
+            // Wake the threads waiting on the counter
+            {
+                std::lock_guard<std::mutex> lock(sleep_mutex_);
+            }
+            wake_.notify_all();
+        }
+
+        void JobSystem::wait(JobCounter const& counter)
+        {
+            std::size_t queue_index = current_queue_();
+
+            while (!counter.is_done())
+            {
+                if (run_one_(queue_index))
+                    continue;
+
+                // Nothing to run: the rest of the work is running elsewhere or
+                // waits for it. Sleep until a job is queued or the counter is done.
+                std::unique_lock<std::mutex> lock(sleep_mutex_);
+                wake_.wait(lock, [&]()
+                {
+                    return counter.is_done() || nb_queued_.load(std::memory_order_acquire) > 0;
+                });
+            }
+        }
+
+        void JobSystem::parallel_for(
+            std::size_t begin,
+            std::size_t end,
+            std::size_t grain,
+            std::function<void(std::size_t, std::size_t)> const& fn
+        )
+        {
+            if (begin >= end)
+                return;
+
+            grain = std::max<std::size_t>(grain, 1);
+
+            // Not worth a job: run inline
+            if (end - begin <= grain || threads_.empty())
+                return fn(begin, end);
+
+            JobCounter counter;
+
+            // fn outlives the jobs since we wait for all of them below
+            for (std::size_t range_begin = begin; range_begin < end; range_begin += grain)
+            {
+                std::size_t range_end = std::min(end, range_begin + grain);
+                schedule([&fn, range_begin, range_end]() { fn(range_begin, range_end); }, &counter);
+            }
+
+            wait(counter);
+        }
+
+        /// MARK: - Private methods
+
+        void JobSystem::worker_loop_(std::size_t queue_index)
+        {
+            current_system = this;
+            current_queue = queue_index;
+
+            while (running_)
+            {
+                if (run_one_(queue_index))
+                    continue;
+
+                // Nothing to run: sleep until a job is queued. Parked jobs are
+                // not counted, so a blocked job does not keep the workers awake.
+                std::unique_lock<std::mutex> lock(sleep_mutex_);
+                wake_.wait(lock, [this]()
+                {
+                    return !running_ || nb_queued_.load(std::memory_order_acquire) > 0;
+                });
+            }
+        }
+
+        bool JobSystem::run_one_(std::size_t queue_index)
+        {
+            if (nb_queued_.load(std::memory_order_acquire) == 0)
+                return false;
+
+            Entry entry;
+            bool found = pop_(*queues_[queue_index], false, entry);
+
+            // Steal, starting with the next queue to spread contention
+            for (std::size_t i = 1; !found && i < queues_.size(); ++i)
+                found = pop_(*queues_[(queue_index + i) % queues_.size()], true, entry);
+
+            if (!found)
+                return false;
+
+            entry.job();
+
+            if (entry.signal)
+                decrement(*entry.signal);
+
+            return true;
+        }
+
+        bool JobSystem::pop_(Queue& queue, bool steal, Entry& entry)
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+
+            if (queue.entries.empty())
+                return false;
+
+            // Owners take the newest job, thieves the oldest
+            if (steal)
+            {
+                entry = std::move(queue.entries.front());
+                queue.entries.pop_front();
+            }
+            else
+            {
+                entry = std::move(queue.entries.back());
+                queue.entries.pop_back();
+            }
+
+            nb_queued_.fetch_sub(1, std::memory_order_acq_rel);
+
+            return true;
+        }
+
+        void JobSystem::push_(Entry entry)
+        {
+            Queue& queue = *queues_[current_queue_()];
+            {
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                queue.entries.push_back(std::move(entry));
+            }
+
+            nb_queued_.fetch_add(1, std::memory_order_release);
+
+            if (!threads_.empty())
+            {
+                // Taking the lock orders this with a worker about to sleep, which
+                // would otherwise miss the notification
+                {
+                    std::lock_guard<std::mutex> lock(sleep_mutex_);
+                }
+                wake_.notify_one();
+            }
+        }
+
+        void JobSystem::release_()
+        {
+            std::lock_guard<std::mutex> lock(parked_mutex_);
+
+            // Keep the parked jobs in scheduling order
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < parked_.size(); ++i)
+            {
+                if (parked_[i].dependency->is_done())
+                {
+                    push_(std::move(parked_[i].entry));
+                    continue;
+                }
+
+                if (kept != i)
+                    parked_[kept] = std::move(parked_[i]);
+
+                ++kept;
+            }
+
+            parked_.erase(parked_.begin() + kept, parked_.end());
+        }
+
+        std::size_t JobSystem::current_queue_() const
+        {
+            return current_system == this ? current_queue : 0;
+        }
+    }
+}
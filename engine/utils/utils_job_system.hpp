@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace engine
+{
+    namespace utils
+    {
+        // Counts the jobs still running for a group of work.
+        // Jobs can be made to wait on a counter: they only start once it reaches
+        // zero. Such a counter must be decremented by the jobs it signals, or
+        // through JobSystem::decrement, which starts the jobs it releases.
+        class JobCounter
+        {
+            public:
+                JobCounter(int value = 0): value_(value)
+                {}
+
+                void increment(int amount = 1)
+                {
+                    value_.fetch_add(amount, std::memory_order_relaxed);
+                }
+
+                // Returns true if this brought the counter to zero
+                bool decrement()
+                {
+                    return value_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+                }
+
+                void reset(int value)
+                {
+                    value_.store(value, std::memory_order_relaxed);
+                }
+
+                bool is_done() const
+                {
+                    return value_.load(std::memory_order_acquire) <= 0;
+                }
+
+            private:
+                std::atomic<int> value_;
+        };
+
+        using Job = std::function<void()>;
+
+        // Work-stealing job system.
+        // Every worker owns a deque: it pushes and pops its own jobs at the back
+        // (LIFO, cache friendly) while idle workers steal from the front of the
+        // others' deques (FIFO, oldest and usually biggest work first).
+        // Threads outside the pool share one extra deque, and help executing
+        // jobs while they wait on a counter, so a pool of 0 workers simply runs
+        // everything on the calling thread.
+        class JobSystem
+        {
+            public:
+                // Defaults to one worker per hardware thread, minus the calling thread
+                explicit JobSystem(std::size_t nb_workers = default_worker_count());
+                ~JobSystem();
+
+                JobSystem(JobSystem const&) = delete;
+                JobSystem& operator=(JobSystem const&) = delete;
+
+                static std::size_t default_worker_count();
+
+                // Queues a job. The signal counter (if any) is incremented now and
+                // decremented once the job has run. The job does not start before
+                // the dependency counter (if any) reached zero: until then it is
+                // parked aside, so workers never spin on it.
+                void schedule(Job job, JobCounter* signal = nullptr, JobCounter const* dependency = nullptr);
+
+                // Decrements a counter jobs may depend on, queuing the jobs it releases
+                void decrement(JobCounter& counter);
+
+                // Runs queued jobs on the calling thread until the counter reaches zero
+                void wait(JobCounter const& counter);
+
+                // Calls fn(range_begin, range_end) over [begin, end) split in ranges
+                // of grain indices, and returns once all of them are done.
+                void parallel_for(
+                    std::size_t begin,
+                    std::size_t end,
+                    std::size_t grain,
+                    std::function<void(std::size_t, std::size_t)> const& fn
+                );
+
+                // Number of threads executing jobs, the waiting thread included
+                std::size_t get_thread_count() const
+                {
+                    return threads_.size() + 1;
+                }
+
+            private:
+                struct Entry
+                {
+                    Job job;
+                    JobCounter* signal;
+                };
+
+                struct Parked
+                {
+                    Entry entry;
+                    JobCounter const* dependency;
+                };
+
+                struct Queue
+                {
+                    std::mutex mutex;
+                    std::deque<Entry> entries;
+                };
+
+                void worker_loop_(std::size_t queue_index);
+
+                // Pops a job from the own queue (back) or steals one from another
+                // queue (front). Returns false if nothing could run.
+                bool run_one_(std::size_t queue_index);
+                bool pop_(Queue& queue, bool steal, Entry& entry);
+
+                void push_(Entry entry);
+                // Queues the parked jobs whose dependency is done
+                void release_();
+
+                std::size_t current_queue_() const;
+
+                // Queue 0 is shared by external threads, queue i + 1 belongs to worker i
+                std::vector<std::unique_ptr<Queue>> queues_;
+                std::vector<std::thread> threads_;
+
+                std::atomic<bool> running_{true};
+
+                // Jobs waiting for their dependency - a handful, scanned linearly
+                // whenever a counter reaches zero
+                std::mutex parked_mutex_;
+                std::vector<Parked> parked_;
+
+                // Jobs queued and not yet picked - all of them ready to run - used
+                // to put idle workers to sleep
+                std::atomic<std::size_t> nb_queued_{0};
+                std::mutex sleep_mutex_;
+                std::condition_variable wake_;
+        };
+    }
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "utils_mapped_file.hpp"
+
+#if defined(__APPLE__) || defined(__unix__)
+    #define ENGINE_HAS_MMAP 1
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#else
+    #define ENGINE_HAS_MMAP 0
+    #include <fstream>
+#endif
+
+namespace engine
+{
+    namespace utils
+    {
+        MappedFile::~MappedFile()
+        {
+            close();
+        }
+
+        bool MappedFile::open(std::string const& path)
+        {
+            close();
+
+#if ENGINE_HAS_MMAP
+            int file = ::open(path.c_str(), O_RDONLY);
+            if (file < 0)
+                return false;
+
+            struct stat info;
+            if (fstat(file, &info) != 0)
+            {
+                ::close(file);
+                return false;
+            }
+
+            size_ = static_cast<std::size_t>(info.st_size);
+
+            // Empty files cannot be mapped, but are valid
+            if (size_ > 0)
+            {
+                void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+                if (data == MAP_FAILED)
+                {
+                    ::close(file);
+                    size_ = 0;
+                    return false;
+                }
+
+                data_ = static_cast<std::byte const*>(data);
+                mapped_ = true;
+            }
+
+            // The mapping keeps its own reference to the file
+            ::close(file);
+
+            return true;
+#else
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+            if (!file)
+                return false;
+
+            buffer_.resize(static_cast<std::size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(reinterpret_cast<char*>(buffer_.data()), buffer_.size());
+
+            data_ = buffer_.data();
+            size_ = buffer_.size();
+
+            return static_cast<bool>(file);
+#endif
+        }
+
+        void MappedFile::close()
+        {
+#if ENGINE_HAS_MMAP
+            if (mapped_)
+                munmap(const_cast<std::byte*>(data_), size_);
+#endif
+
+            buffer_.clear();
+            data_ = nullptr;
+            size_ = 0;
+            mapped_ = false;
+        }
+    }
+}
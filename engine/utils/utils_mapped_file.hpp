@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace engine
+{
+    namespace utils
+    {
+        // A read-only view of a whole file.
+        // The file is memory-mapped where available, so opening it costs nothing
+        // until its pages are touched; elsewhere it is read into memory.
+        class MappedFile
+        {
+            public:
+                MappedFile() = default;
+                ~MappedFile();
+
+                MappedFile(MappedFile const&) = delete;
+                MappedFile& operator=(MappedFile const&) = delete;
+
+                // Returns false if the file cannot be opened
+                bool open(std::string const& path);
+                void close();
+
+                std::byte const* data() const
+                {
+                    return data_;
+                }
+
+                std::size_t size() const
+                {
+                    return size_;
+                }
+
+            private:
+                std::byte const* data_ = nullptr;
+                std::size_t size_ = 0;
+
+                // True if data_ points to a mapping, false if it points to buffer_
+                bool mapped_ = false;
+                std::vector<std::byte> buffer_{};
+        };
+    }
+}
@@ -2,6 +2,7 @@
 
 #define _USE_MATH_DEFINES // for C++
 #include <cmath>
+#include <cstdint>
 
 namespace engine
 {
@@ -21,5 +22,24 @@ namespace engine
         {
             return radians * 180.0 / M_PI;
         }
+
+        // Spreads the 10 low bits of value two bits apart
+        inline std::uint32_t spread_bits_3D(std::uint32_t value)
+        {
+            value &= 0x3ff;
+            value = (value | (value << 16)) & 0x030000ff;
+            value = (value | (value << 8)) & 0x0300f00f;
+            value = (value | (value << 4)) & 0x030c30c3;
+            value = (value | (value << 2)) & 0x09249249;
+
+            return value;
+        }
+
+        // Position along the Z-order curve of a point with 10-bit coordinates:
+        // points close in space tend to get close keys
+        inline std::uint32_t morton_3D(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+        {
+            return spread_bits_3D(x) | (spread_bits_3D(y) << 1) | (spread_bits_3D(z) << 2);
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "utils_aligned_allocator.hpp"
+
+namespace engine
+{
+    namespace utils
+    {
+        // Bounded lock-free multi-producer / single-consumer queue.
+        // A ring of cells, each with a sequence number telling whose turn it is
+        // (D. Vyukov's bounded queue): producers claim a position with one CAS
+        // on the shared tail, fill the cell and publish it by bumping its
+        // sequence. The one consumer reads the cells in order without any
+        // read-modify-write. Nobody ever waits on a lock; a full ring makes
+        // try_push fail instead of blocking.
+        template<typename T>
+        class MPSCRing
+        {
+            public:
+                // The capacity must be a power of two
+                explicit MPSCRing(std::size_t capacity)
+                    : mask_(capacity - 1), cells_(new Cell[capacity])
+                {
+                    assert(capacity >= 2 && (capacity & (capacity - 1)) == 0 && "Ring capacity must be a power of two.");
+
+                    for (std::size_t i = 0; i < capacity; ++i)
+                        cells_[i].sequence.store(i, std::memory_order_relaxed);
+                }
+
+                ~MPSCRing()
+                {
+                    drain([](T&) {});
+                }
+
+                MPSCRing(MPSCRing const&) = delete;
+                MPSCRing& operator=(MPSCRing const&) = delete;
+
+                // Any thread. Returns false, leaving the ring untouched, when it is full.
+                bool try_push(T const& value)
+                {
+                    std::size_t position = tail_.load(std::memory_order_relaxed);
+                    Cell* cell;
+
+                    for (;;)
+                    {
+                        cell = &cells_[position & mask_];
+                        std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                        std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+                        // The cell is free for this position: try to claim it
+                        if (difference == 0)
+                        {
+                            if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                                break;
+                        }
+                        // The cell still holds the value of the previous lap: full
+                        else if (difference < 0)
+                        {
+                            return false;
+                        }
+                        // Another producer claimed it first
+                        else
+                        {
+                            position = tail_.load(std::memory_order_relaxed);
+                        }
+                    }
+
+                    new (cell->storage) T(value);
+                    cell->sequence.store(position + 1, std::memory_order_release);
+
+                    return true;
+                }
+
+                // Consumer thread only. Returns false when there is nothing to pop,
+                // including when the next value is claimed but not written yet.
+                bool try_pop(T& value)
+                {
+                    return pop_([&](T& stored) { value = std::move(stored); });
+                }
+
+                // Consumer thread only. Calls fn(T&) for every value available, in
+                // order, and returns how many there were. Values pushed meanwhile
+                // may or may not be part of it.
+                template<typename F>
+                std::size_t drain(F&& fn)
+                {
+                    std::size_t count = 0;
+                    while (pop_(fn))
+                        ++count;
+
+                    return count;
+                }
+
+                std::size_t capacity() const
+                {
+                    return mask_ + 1;
+                }
+
+            private:
+                template<typename F>
+                bool pop_(F&& fn)
+                {
+                    Cell& cell = cells_[head_ & mask_];
+                    std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+
+                    if (sequence != head_ + 1)
+                        return false;
+
+                    T* stored = std::launder(reinterpret_cast<T*>(cell.storage));
+                    fn(*stored);
+                    stored->~T();
+
+                    // Hand the cell over to the producers of the next lap
+                    cell.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+                    ++head_;
+
+                    return true;
+                }
+
+                struct alignas(CACHE_LINE_SIZE) Cell
+                {
+                    std::atomic<std::size_t> sequence;
+                    alignas(T) std::byte storage[sizeof(T)];
+                };
+
+                std::size_t const mask_;
+                std::unique_ptr<Cell[]> cells_;
+
+                // Next position to write, shared by the producers, and next position
+                // to read, owned by the consumer - on separate cache lines
+                alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> tail_{0};
+                alignas(CACHE_LINE_SIZE) std::size_t head_ = 0;
+        };
+    }
+}
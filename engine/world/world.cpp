@@ -0,0 +1,144 @@
+#include "world.hpp"
+
+namespace engine
+{
+    void World::init(utils::JobSystem& job_system)
+    {
+        job_system_ = &job_system;
+
+        coordinator_ = std::make_unique<Coordinator>();
+        coordinator_->init();
+
+        /// Register components
+
+        coordinator_->register_component<component::Transform>();
+        coordinator_->register_component<component::Camera>();
+        coordinator_->register_component<component::RigidBody>();
+        coordinator_->register_component<component::Gravity>();
+        coordinator_->register_component<component::Hierarchy>();
+        coordinator_->register_component<component::WorldTransform>();
+        coordinator_->register_component<component::Collidable>();
+
+        // Hashes identify the component types in saved worlds: never change them
+        snapshot_ = std::make_unique<ecs::ECSSnapshot>();
+        snapshot_->add<component::Transform>("Transform"_hash);
+        snapshot_->add<component::Camera>("Camera"_hash);
+        snapshot_->add<component::RigidBody>("RigidBody"_hash);
+        snapshot_->add<component::Gravity>("Gravity"_hash);
+        snapshot_->add<component::Hierarchy>("Hierarchy"_hash);
+        snapshot_->add<component::WorldTransform>("WorldTransform"_hash);
+        snapshot_->add<component::Collidable>("Collidable"_hash);
+
+        /// Events - input arriving faster than frames only matters once per frame
+
+        coordinator_->coalesce_events_replace<event::MousePositionEvent>();
+        coordinator_->coalesce_events_replace<event::ResizeEvent>();
+        coordinator_->coalesce_events_replace<event::CameraAnglesEvent>();
+        coordinator_->coalesce_events_accumulate<event::ScrollOffsetEvent>();
+
+        /// Resources
+
+        coordinator_->set_resource(Input {});
+
+        /// Systems
+
+        physics_system_ = coordinator_->register_system<system::PhysicsSystem>(*coordinator_, job_system_);
+        {
+            engine::ecs::ECSMask mask;
+            mask.set(coordinator_->get_component_type<component::Transform>());
+            mask.set(coordinator_->get_component_type<component::Gravity>());
+            mask.set(coordinator_->get_component_type<component::RigidBody>());
+            coordinator_->set_system_mask<system::PhysicsSystem>(mask);
+        }
+
+        physics_system_->init();
+
+        camera_control_system_ = coordinator_->register_system<system::CameraControlSystem>(*coordinator_);
+        {
+            engine::ecs::ECSMask mask;
+            mask.set(coordinator_->get_component_type<component::Transform>());
+            mask.set(coordinator_->get_component_type<component::Camera>());
+            mask.set(coordinator_->get_component_type<engine::component::RigidBody>());
+            coordinator_->set_system_mask<system::CameraControlSystem>(mask);
+        }
+
+        camera_control_system_->init();
+
+        transform_hierarchy_system_ = coordinator_->register_system<system::TransformHierarchySystem>(*coordinator_);
+        {
+            engine::ecs::ECSMask mask;
+            mask.set(coordinator_->get_component_type<component::Transform>());
+            mask.set(coordinator_->get_component_type<component::WorldTransform>());
+            coordinator_->set_system_mask<system::TransformHierarchySystem>(mask);
+        }
+
+        transform_hierarchy_system_->init();
+
+        spatial_sort_system_ = coordinator_->register_system<system::SpatialSortSystem>(*coordinator_);
+        {
+            engine::ecs::ECSMask mask;
+            mask.set(coordinator_->get_component_type<component::Transform>());
+            mask.set(coordinator_->get_component_type<component::Gravity>());
+            mask.set(coordinator_->get_component_type<component::RigidBody>());
+            coordinator_->set_system_mask<system::SpatialSortSystem>(mask);
+        }
+
+        /// Schedule - systems declaring conflicting accesses keep this order
+
+        scheduler_ = std::make_unique<ecs::ECSScheduler>();
+        scheduler_->add(camera_control_system_, "CameraControlSystem");
+        scheduler_->add(spatial_sort_system_, "SpatialSortSystem");
+        scheduler_->add(physics_system_, "PhysicsSystem");
+        scheduler_->add(transform_hierarchy_system_, "TransformHierarchySystem");
+    }
+
+    void World::step(float dt)
+    {
+        assert(scheduler_);
+
+        // Events posted since the last step are delivered before any system runs
+        coordinator_->dispatch_events();
+
+        scheduler_->run(*job_system_, dt);
+
+        // Sync point: component observers get this step's batches
+        coordinator_->dispatch_observers();
+    }
+
+    Coordinator& World::get_coordinator()
+    {
+        assert(coordinator_);
+
+        return *coordinator_;
+    }
+
+    system::CameraControlSystem& World::get_camera_control_system()
+    {
+        assert(camera_control_system_);
+
+        return *camera_control_system_;
+    }
+
+    void World::dump_schedule(std::ostream& stream)
+    {
+        assert(scheduler_);
+
+        scheduler_->dump(stream);
+    }
+
+    bool World::save(const std::string& path)
+    {
+        assert(coordinator_);
+        assert(snapshot_);
+
+        return coordinator_->save_snapshot(*snapshot_, path);
+    }
+
+    bool World::load(const std::string& path)
+    {
+        assert(coordinator_);
+        assert(snapshot_);
+
+        return coordinator_->load_snapshot(*snapshot_, path);
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include "coordinator.hpp"
+
+#include "event.hpp"
+#include "event_types.hpp"
+
+#include "ecs_scheduler.hpp"
+#include "ecs_snapshot.hpp"
+#include "utils_hash.hpp"
+#include "utils_job_system.hpp"
+#include "utils_types.hpp"
+
+#include "active_camera.hpp"
+#include "gravity.hpp"
+#include "camera.hpp"
+#include "collidable.hpp"
+#include "hierarchy.hpp"
+#include "rigid_body.hpp"
+#include "transform.hpp"
+#include "world_transform.hpp"
+
+#include "camera_control_system.hpp"
+#include "physics_system.hpp"
+#include "spatial_sort_system.hpp"
+#include "transform_hierarchy_system.hpp"
+
+namespace engine
+{
+    // A self-contained simulation: a coordinator holding the engine components,
+    // resources and systems, and the schedule running them. Worlds share no
+    // state, so a process can host any number of them and step different
+    // worlds concurrently - each world being stepped by one thread at a time.
+    class World
+    {
+        public:
+            // Systems run on the job system, which must outlive the world
+            void init(utils::JobSystem& job_system);
+            // Delivers the queued events, runs every system once, then delivers
+            // the component observer batches
+            void step(float dt);
+
+            Coordinator& get_coordinator();
+            system::CameraControlSystem& get_camera_control_system();
+
+            // Debug: the system schedule of the last step with per-system timings
+            void dump_schedule(std::ostream& stream);
+            // Writes / replaces the entities and components of the world
+            bool save(const std::string& path);
+            bool load(const std::string& path);
+        private:
+            utils::JobSystem* job_system_ = nullptr;
+
+            // Systems keep a pointer to the coordinator: it must not move
+            std::unique_ptr<Coordinator> coordinator_{};
+
+            std::shared_ptr<system::PhysicsSystem> physics_system_{};
+            std::shared_ptr<system::CameraControlSystem> camera_control_system_{};
+            std::shared_ptr<system::TransformHierarchySystem> transform_hierarchy_system_{};
+            std::shared_ptr<system::SpatialSortSystem> spatial_sort_system_{};
+
+            std::unique_ptr<ecs::ECSScheduler> scheduler_{};
+            std::unique_ptr<ecs::ECSSnapshot> snapshot_{};
+    };
+}
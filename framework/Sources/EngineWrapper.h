@@ -6,13 +6,6 @@
 
 #include <MetalKit/MetalKit.h>
 
-#ifdef __cplusplus
-static uint32_t EVENT_CAMERA_ANGLES = engine::event::CAMERA_ANGLES;
-static uint32_t EVENT_CAMERA_ANGLES_PITCH = engine::event::camera_angles::PITCH;
-static uint32_t EVENT_CAMERA_ANGLES_YAW = engine::event::camera_angles::YAW;
-static uint32_t EVENT_CAMERA_ANGLES_ROLL = engine::event::camera_angles::ROLL;
-#endif
-
 @interface EngineWrapper: NSObject
 
 #ifdef __cplusplus
@@ -36,12 +36,9 @@
 - (void)sendCameraEventWithPitchYawRoll:(double) pitch
                                     yaw:(double) yaw
                                    roll:(double) roll {
-    engine::event::Event event(EVENT_CAMERA_ANGLES);
-    event.set_parameter(EVENT_CAMERA_ANGLES_PITCH, pitch);
-    event.set_parameter(EVENT_CAMERA_ANGLES_YAW, yaw);
-    event.set_parameter(EVENT_CAMERA_ANGLES_ROLL, roll);
+    engine::event::Event event(engine::event::CameraAnglesEvent { pitch, yaw, roll });
     
-    self.engine_->send_event(event);
+    self.engine_->post_event(event);
 }
 
 @end
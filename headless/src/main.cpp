@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "world.hpp"
+
+#include "utils_job_system.hpp"
+#include "utils_types.hpp"
+
+#include "event.hpp"
+#include "event_recording.hpp"
+#include "event_types.hpp"
+
+// Steps many independent worlds across all cores, without window nor graphics,
+// and reports the aggregate number of world steps per second.
+// With --replay, steps one world through a recording made by the desktop app
+// (--record), at the recorded timesteps or a fixed one, and reports the
+// distribution of the frame times - the same input on every run.
+//
+// Usage: headless [worlds] [bodies per world] [steps]
+//        headless --replay <recording> [bodies] [fixed dt]
+
+static constexpr float STEP_DT = 1.0f / 60.0f;
+
+static void populate(engine::World& world, std::size_t nb_bodies, std::size_t seed)
+{
+    engine::Coordinator& coordinator = world.get_coordinator();
+
+    engine::component::Gravity gravity;
+    gravity.force = Diligent::float3(0, -9.81f, 0);
+
+    engine::ecs::ECSPrefab body;
+    body.set(engine::component::Transform {})
+        .set(engine::component::RigidBody {})
+        .set(gravity)
+        .set(engine::component::WorldTransform {});
+
+    std::vector<engine::ecs::ECSEntity> bodies = coordinator.instantiate(body, nb_bodies);
+
+    for (std::size_t i = 0; i < bodies.size(); ++i)
+    {
+        // Bodies on a grid, thrown upward at different speeds
+        float x = static_cast<float>(i % 32);
+        float y = static_cast<float>((i / 32) % 32);
+        float z = static_cast<float>(i / 1024);
+
+        coordinator.get_component<engine::component::Transform>(bodies[i]).position = Diligent::float3(x, y, z);
+        coordinator.get_component<engine::component::RigidBody>(bodies[i]).velocity = Diligent::float3(0, static_cast<float>((i + seed) % 7), 0);
+    }
+}
+
+static int replay(std::string const& path, std::size_t nb_bodies, float fixed_dt)
+{
+    engine::event::EventRecording recording;
+
+    if (!recording.load(path) || recording.get_frame_count() == 0)
+    {
+        std::cerr << "Could not read a recording from " << path << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    // Like the engine: one world, its systems running over all cores
+    engine::utils::JobSystem job_system;
+
+    engine::World world;
+    world.init(job_system);
+
+    populate(world, nb_bodies, 0);
+
+    engine::Coordinator& coordinator = world.get_coordinator();
+
+    std::size_t nb_frames = recording.get_frame_count();
+    std::vector<double> frame_times(nb_frames);
+
+    for (std::size_t frame = 0; frame < nb_frames; ++frame)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        recording.each_event(frame, [&](engine::event::Event const& recorded, engine::event::EventRecording::Delivery delivery)
+        {
+            engine::event::Event event = recorded;
+
+            if (delivery == engine::event::EventRecording::Delivery::SENT)
+                coordinator.send_event(event);
+            else
+                coordinator.post_event(event);
+        });
+
+        world.step(fixed_dt > 0.0f ? fixed_dt : recording.get_dt(frame));
+
+        frame_times[frame] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    double total = 0.0;
+    for (double frame_time : frame_times)
+        total += frame_time;
+
+    std::sort(frame_times.begin(), frame_times.end());
+
+    auto percentile = [&](double p)
+    {
+        return frame_times[static_cast<std::size_t>(p * double(nb_frames - 1))];
+    };
+
+    std::cout << nb_frames << " frames x " << nb_bodies << " bodies on "
+              << job_system.get_thread_count() << " threads"
+              << (fixed_dt > 0.0f ? ", fixed dt" : ", recorded dt") << "\n"
+              << std::fixed << std::setprecision(3)
+              << "frame ms: mean " << total / double(nb_frames)
+              << ", min " << frame_times.front()
+              << ", p50 " << percentile(0.50)
+              << ", p90 " << percentile(0.90)
+              << ", p99 " << percentile(0.99)
+              << ", max " << frame_times.back() << std::endl;
+
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 2 && std::strcmp(argv[1], "--replay") == 0)
+    {
+        std::size_t nb_bodies = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1000;
+        float fixed_dt = argc > 4 ? std::strtof(argv[4], nullptr) : 0.0f;
+
+        return replay(argv[2], nb_bodies, fixed_dt);
+    }
+
+    std::size_t nb_worlds = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256;
+    std::size_t nb_bodies = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000;
+    std::size_t nb_steps = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 600;
+
+    if (nb_worlds == 0 || nb_steps == 0)
+    {
+        std::cerr << "Usage: " << argv[0] << " [worlds] [bodies per world] [steps]\n"
+                  << "       " << argv[0] << " --replay <recording> [bodies] [fixed dt]" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    engine::utils::JobSystem job_system;
+
+    // Parallelism comes from stepping different worlds at once: within a world
+    // the systems run one after the other, on a job system without workers
+    std::vector<std::unique_ptr<engine::utils::JobSystem>> world_job_systems;
+    std::vector<std::unique_ptr<engine::World>> worlds;
+
+    for (std::size_t i = 0; i < nb_worlds; ++i)
+    {
+        world_job_systems.push_back(std::make_unique<engine::utils::JobSystem>(0));
+
+        worlds.push_back(std::make_unique<engine::World>());
+        worlds.back()->init(*world_job_systems.back());
+
+        populate(*worlds.back(), nb_bodies, i);
+    }
+
+    Input input;
+    input.gravity = true;
+
+    for (auto& world : worlds)
+    {
+        engine::event::Event event(engine::event::InputEvent { input });
+        world->get_coordinator().send_event(event);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Worlds are independent: each job steps its worlds to the end
+    job_system.parallel_for(0, worlds.size(), 1, [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+            for (std::size_t step = 0; step < nb_steps; ++step)
+                worlds[i]->step(STEP_DT);
+    });
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double steps_per_second = double(nb_worlds * nb_steps) / seconds;
+
+    std::cout << nb_worlds << " worlds x " << nb_bodies << " bodies x " << nb_steps << " steps on "
+              << job_system.get_thread_count() << " threads\n"
+              << std::fixed << std::setprecision(3) << seconds << "s, "
+              << std::setprecision(0) << steps_per_second << " world steps/s, "
+              << steps_per_second * double(nb_bodies) << " body steps/s" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "coordinator.hpp"
+
+#include "test_check.hpp"
+
+// each_changed reports exactly the components added or changed since a tick,
+// however slots moved in between: swap-removes and swap_slots carry their
+// ticks along, and a changed slot moved into an unchanged block must not be
+// skipped with it.
+
+using namespace engine;
+
+struct Position
+{
+    float x = 0.0f;
+};
+
+static std::vector<ecs::ECSEntity> changed_since(Coordinator& coordinator, ecs::ECSTick since)
+{
+    std::vector<ecs::ECSEntity> changed;
+    coordinator.each_changed<Position>(since, [&](ecs::ECSEntity entity, Position&)
+    {
+        changed.push_back(entity);
+    });
+
+    std::sort(changed.begin(), changed.end());
+
+    return changed;
+}
+
+static std::vector<ecs::ECSEntity> sorted(std::vector<ecs::ECSEntity> entities)
+{
+    std::sort(entities.begin(), entities.end());
+
+    return entities;
+}
+
+// A few changes far apart, then slots moved around them
+static void moved_slots()
+{
+    constexpr std::size_t COUNT = 1000;
+
+    Coordinator coordinator;
+    coordinator.init();
+
+    coordinator.register_component<Position>();
+    coordinator.enable_change_tracking<Position>();
+
+    auto* positions = coordinator.get_component_array<Position>();
+
+    std::vector<ecs::ECSEntity> entities = coordinator.create_entities(COUNT);
+    for (std::size_t i = 0; i < COUNT; ++i)
+        coordinator.add_component(entities[i], Position { float(i) });
+
+    ecs::ECSTick since = coordinator.advance_tick();
+    TEST_CHECK(changed_since(coordinator, since).empty());
+
+    for (std::size_t i : { 5, 130, 131, 700, 999 })
+        coordinator.mark_changed<Position>(entities[i]);
+
+    TEST_CHECK(changed_since(coordinator, since) == sorted({ entities[5], entities[130], entities[131], entities[700], entities[999] }));
+
+    // The last slot, changed, fills an unchanged block; a changed one goes away
+    coordinator.remove_component<Position>(entities[200]);
+    TEST_CHECK(positions->index_of(entities[999]) == 200);
+    coordinator.remove_component<Position>(entities[130]);
+
+    TEST_CHECK(changed_since(coordinator, since) == sorted({ entities[5], entities[131], entities[700], entities[999] }));
+
+    // Swapped into another unchanged block
+    coordinator.swap_component_slots<Position>(positions->index_of(entities[700]), 450);
+    TEST_CHECK(positions->index_of(entities[700]) == 450);
+
+    TEST_CHECK(changed_since(coordinator, since) == sorted({ entities[5], entities[131], entities[700], entities[999] }));
+
+    // Later ticks only see what came after them, additions included
+    ecs::ECSTick later = coordinator.advance_tick();
+    coordinator.mark_changed<Position>(entities[42]);
+    coordinator.add_component(entities[200], Position { 200.0f });
+
+    TEST_CHECK(changed_since(coordinator, later) == sorted({ entities[42], entities[200] }));
+    TEST_CHECK(changed_since(coordinator, since).size() == 6);
+
+    // Everything counts as changed since the first tick
+    TEST_CHECK(changed_since(coordinator, 0).size() == positions->size());
+}
+
+// Random changes, additions, removals and swaps against the tick each entity
+// was last changed at
+static void random_operations()
+{
+    constexpr std::size_t COUNT = 500;
+
+    std::mt19937 random(7);
+
+    Coordinator coordinator;
+    coordinator.init();
+
+    coordinator.register_component<Position>();
+    coordinator.enable_change_tracking<Position>();
+
+    auto* positions = coordinator.get_component_array<Position>();
+
+    std::vector<ecs::ECSEntity> entities = coordinator.create_entities(COUNT);
+    std::map<ecs::ECSEntity, ecs::ECSTick> changed_at;
+
+    std::vector<ecs::ECSTick> sinces { coordinator.get_tick() };
+
+    for (std::size_t step = 0; step < 4000; ++step)
+    {
+        ecs::ECSEntity entity = entities[random() % COUNT];
+        bool owned = coordinator.has_component<Position>(entity);
+
+        switch (random() % 4)
+        {
+            case 0:
+                if (owned)
+                {
+                    coordinator.remove_component<Position>(entity);
+                    changed_at.erase(entity);
+                }
+                else
+                {
+                    coordinator.add_component(entity, Position {});
+                    changed_at[entity] = coordinator.get_tick();
+                }
+                break;
+
+            case 1:
+                if (owned)
+                {
+                    coordinator.mark_changed<Position>(entity);
+                    changed_at[entity] = coordinator.get_tick();
+                }
+                break;
+
+            case 2:
+                if (positions->size() > 1)
+                    coordinator.swap_component_slots<Position>(random() % positions->size(), random() % positions->size());
+                break;
+
+            default:
+                if (step % 16 == 0)
+                    sinces.push_back(coordinator.advance_tick());
+                break;
+        }
+
+        if (step % 100 != 99)
+            continue;
+
+        for (ecs::ECSTick since : sinces)
+        {
+            std::vector<ecs::ECSEntity> expected;
+            for (auto const& [owner, tick] : changed_at)
+                if (tick >= since)
+                    expected.push_back(owner);
+
+            TEST_CHECK(changed_since(coordinator, since) == expected);
+        }
+    }
+}
+
+int main()
+{
+    moved_slots();
+    random_operations();
+
+    return EXIT_SUCCESS;
+}
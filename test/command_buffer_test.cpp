@@ -0,0 +1,152 @@
+#include <cstdlib>
+#include <vector>
+
+#include "coordinator.hpp"
+#include "ecs_command_buffer.hpp"
+#include "ecs_system.hpp"
+
+#include "test_check.hpp"
+
+// Coordinator::flush applies the commands of each entity in recording order,
+// whatever the other entities recorded in between, gives provisional entities
+// their real handles, and drops the commands of entities not alive any more.
+
+using namespace engine;
+
+struct Position
+{
+    float x = 0.0f;
+};
+
+struct Velocity
+{
+    float x = 0.0f;
+};
+
+class MovingSystem : public ecs::ECSSystem
+{};
+
+int main()
+{
+    Coordinator coordinator;
+    coordinator.init();
+
+    coordinator.register_component<Position>();
+    coordinator.register_component<Velocity>();
+
+    auto moving_system = coordinator.register_system<MovingSystem>();
+    {
+        ecs::ECSMask mask;
+        mask.set(coordinator.get_component_type<Position>());
+        mask.set(coordinator.get_component_type<Velocity>());
+        coordinator.set_system_mask<MovingSystem>(mask);
+    }
+
+    auto* positions = coordinator.get_component_array<Position>();
+    auto* velocities = coordinator.get_component_array<Velocity>();
+
+    ecs::ECSCommandBuffer commands;
+
+    // Interleaved entities: each one ends up with what it recorded last
+    ecs::ECSEntity first = coordinator.create_entity();
+    ecs::ECSEntity second = coordinator.create_entity();
+
+    commands.add_component(second, Position { 1.0f });
+    commands.add_component(first, Position { 2.0f });
+    commands.add_component(second, Velocity { 3.0f });
+    commands.remove_component<Position>(first);
+    commands.add_component(first, Velocity { 4.0f });
+    commands.add_component(first, Position { 5.0f });
+    commands.remove_component<Velocity>(second);
+
+    coordinator.flush(commands);
+    TEST_CHECK(commands.empty());
+
+    TEST_CHECK(coordinator.has_component<Position>(first) && coordinator.has_component<Velocity>(first));
+    TEST_CHECK(coordinator.get_component<Position>(first).x == 5.0f);
+    TEST_CHECK(coordinator.get_component<Velocity>(first).x == 4.0f);
+
+    TEST_CHECK(coordinator.has_component<Position>(second) && !coordinator.has_component<Velocity>(second));
+    TEST_CHECK(coordinator.get_component<Position>(second).x == 1.0f);
+
+    TEST_CHECK(moving_system->entities_.size() == 1 && moving_system->entities_.contains(first));
+
+    // Provisional handles, used before and after other entities' commands
+    ecs::ECSEntity created = commands.create_entity();
+    ecs::ECSEntity other = commands.create_entity();
+
+    TEST_CHECK(ecs::ECSCommandBuffer::is_provisional(created) && ecs::ECSCommandBuffer::is_provisional(other));
+
+    commands.add_component(created, Position { 6.0f });
+    commands.add_component(second, Velocity { 7.0f });
+    commands.add_component(other, Position { 8.0f });
+    commands.add_component(created, Velocity { 9.0f });
+
+    coordinator.flush(commands);
+
+    TEST_CHECK(coordinator.get_entity_count() == 4);
+    TEST_CHECK(moving_system->entities_.size() == 3);
+
+    // The created entities are found through their components
+    std::size_t found = 0;
+    for (std::size_t i = 0; i < positions->size(); ++i)
+    {
+        ecs::ECSEntity entity = positions->entities()[i];
+
+        TEST_CHECK(coordinator.is_alive(entity) && !ecs::ECSCommandBuffer::is_provisional(entity));
+
+        if (positions->components()[i].x == 6.0f)
+        {
+            TEST_CHECK(coordinator.get_component<Velocity>(entity).x == 9.0f);
+            TEST_CHECK(moving_system->entities_.contains(entity));
+            ++found;
+        }
+        else if (positions->components()[i].x == 8.0f)
+        {
+            TEST_CHECK(!coordinator.has_component<Velocity>(entity));
+            ++found;
+        }
+    }
+
+    TEST_CHECK(found == 2);
+
+    // Added, removed and destroyed in one batch: gone from every array and system
+    commands.remove_component<Position>(second);
+    commands.remove_component<Velocity>(second);
+    commands.add_component(second, Velocity { 10.0f });
+    commands.add_component(second, Position { 11.0f });
+    commands.destroy_entity(second);
+    // Ignored, the entity being destroyed already
+    commands.add_component(second, Position { 12.0f });
+
+    std::size_t position_count = positions->size();
+    std::size_t velocity_count = velocities->size();
+
+    coordinator.flush(commands);
+
+    TEST_CHECK(!coordinator.is_alive(second));
+    TEST_CHECK(coordinator.get_entity_count() == 3);
+    TEST_CHECK(positions->size() == position_count - 1 && !positions->contains(second));
+    TEST_CHECK(velocities->size() == velocity_count - 1 && !velocities->contains(second));
+    TEST_CHECK(!moving_system->entities_.contains(second));
+    TEST_CHECK(moving_system->entities_.size() == 2);
+
+    // Stale handles: the commands of a destroyed entity never reach the one
+    // recycling its index
+    ecs::ECSEntity recycled = coordinator.create_entity();
+    TEST_CHECK(ecs::entity_index(recycled) == ecs::entity_index(second));
+
+    commands.add_component(second, Position { 13.0f });
+    commands.add_component(recycled, Velocity { 14.0f });
+    commands.destroy_entity(second);
+    commands.remove_component<Position>(second);
+
+    coordinator.flush(commands);
+
+    TEST_CHECK(coordinator.is_alive(recycled));
+    TEST_CHECK(!coordinator.has_component<Position>(recycled));
+    TEST_CHECK(coordinator.get_component<Velocity>(recycled).x == 14.0f);
+    TEST_CHECK(coordinator.get_entity_count() == 4);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,217 @@
+#include <cstdlib>
+#include <vector>
+
+#include "coordinator.hpp"
+#include "ecs_archetype.hpp"
+#include "ecs_system.hpp"
+
+#include "test_check.hpp"
+
+// Destroying a stale handle - its entity destroyed already and its index
+// possibly recycled - must leave the living entities alone, in release
+// builds too. A batch of destroyed entities leaves the component arrays and
+// system lists holding exactly the survivors. Archetype locations remember
+// the version of their entity, so storage never acts on a stale handle.
+
+using namespace engine;
+
+struct Position
+{
+    float x = 0.0f;
+};
+
+struct Velocity
+{
+    float x = 0.0f;
+};
+
+struct Frozen
+{
+};
+
+class MovingSystem : public ecs::ECSSystem
+{};
+
+// No mask: never holds entities, and must not be asked to remove any
+class MasklessSystem : public ecs::ECSSystem
+{};
+
+static void batch()
+{
+    constexpr std::size_t COUNT = 1000;
+
+    Coordinator coordinator;
+    coordinator.init();
+
+    coordinator.register_component<Position>();
+    coordinator.register_component<Velocity>();
+    coordinator.register_component<Frozen>();
+    coordinator.enable_change_tracking<Position>();
+
+    auto moving_system = coordinator.register_system<MovingSystem>();
+    {
+        ecs::ECSMask mask;
+        mask.set(coordinator.get_component_type<Position>());
+        mask.set(coordinator.get_component_type<Velocity>());
+        coordinator.set_system_mask<MovingSystem>(mask);
+    }
+
+    std::vector<ecs::ECSEntity> entities = coordinator.create_entities(COUNT);
+    for (std::size_t i = 0; i < COUNT; ++i)
+    {
+        coordinator.add_component(entities[i], Position { float(i) });
+        if (i % 2 == 0)
+            coordinator.add_component(entities[i], Velocity { float(i) });
+        if (i % 5 == 0)
+            coordinator.add_component<Frozen>(entities[i]);
+    }
+
+    // A tick after every addition, to tell the survivors' ticks apart
+    ecs::ECSTick since = coordinator.advance_tick();
+    for (std::size_t i = 0; i < COUNT; i += 7)
+        coordinator.mark_changed<Position>(entities[i]);
+
+    // Every third entity, some of them twice, and a stale handle
+    ecs::ECSEntity stale = coordinator.create_entity();
+    coordinator.destroy_entity(stale);
+
+    std::vector<ecs::ECSEntity> destroyed { stale };
+    for (std::size_t i = 0; i < COUNT; i += 3)
+    {
+        destroyed.push_back(entities[i]);
+        if (i % 9 == 0)
+            destroyed.push_back(entities[i]);
+    }
+
+    coordinator.destroy_entities(destroyed);
+
+    std::size_t survivors = 0, moving = 0;
+    for (std::size_t i = 0; i < COUNT; ++i)
+    {
+        bool alive = i % 3 != 0;
+        TEST_CHECK(coordinator.is_alive(entities[i]) == alive);
+
+        if (!alive)
+            continue;
+
+        ++survivors;
+        moving += i % 2 == 0;
+
+        TEST_CHECK(coordinator.get_component<Position>(entities[i]).x == float(i));
+        TEST_CHECK(coordinator.has_component<Frozen>(entities[i]) == (i % 5 == 0));
+        if (i % 2 == 0)
+            TEST_CHECK(coordinator.get_component<Velocity>(entities[i]).x == float(i));
+    }
+
+    TEST_CHECK(coordinator.get_entity_count() == survivors);
+    TEST_CHECK(coordinator.get_component_array<Position>()->size() == survivors);
+    TEST_CHECK(coordinator.get_component_array<Velocity>()->size() == moving);
+    TEST_CHECK(moving_system->entities_.size() == moving);
+
+    for (ecs::ECSEntity entity : moving_system->entities_)
+        TEST_CHECK(coordinator.is_alive(entity) && coordinator.has_component<Velocity>(entity));
+
+    // Ticks moved along with their components
+    std::size_t changed = 0;
+    coordinator.each_changed<Position>(since, [&](ecs::ECSEntity entity, Position& position)
+    {
+        std::size_t i = static_cast<std::size_t>(position.x);
+
+        TEST_CHECK(entity == entities[i] && i % 7 == 0 && i % 3 != 0);
+        ++changed;
+    });
+
+    TEST_CHECK(changed == (COUNT + 6) / 7 - (COUNT + 20) / 21);
+
+    // Every freed index is handed out again, once
+    std::vector<ecs::ECSEntity> recycled = coordinator.create_entities(COUNT - survivors + 1);
+    std::vector<bool> used(COUNT + 1, false);
+    for (ecs::ECSEntity entity : recycled)
+    {
+        TEST_CHECK(ecs::entity_index(entity) <= COUNT && !used[ecs::entity_index(entity)]);
+        used[ecs::entity_index(entity)] = true;
+    }
+}
+
+static void archetype_locations()
+{
+    ecs::ECSArchetypeStorage storage;
+    storage.register_component(0, ecs::ECSComponentInfo { sizeof(Position), alignof(Position) });
+
+    ecs::ECSEntity old = ecs::make_entity(3, 0);
+    ecs::ECSEntity current = ecs::make_entity(3, 1);
+    ecs::ECSEntity other = ecs::make_entity(4, 0);
+
+    Position position { 1.0f };
+    storage.add(old, 0, &position);
+    storage.entity_destroyed(old);
+
+    position.x = 2.0f;
+    storage.add(current, 0, &position);
+    position.x = 3.0f;
+    storage.add(other, 0, &position);
+
+    // The index now holds a newer entity: the stale handle is ignored
+    storage.entity_destroyed(old);
+
+    TEST_CHECK(static_cast<Position*>(storage.get(current, 0))->x == 2.0f);
+    TEST_CHECK(static_cast<Position*>(storage.get(other, 0))->x == 3.0f);
+
+    storage.entity_destroyed(current);
+    TEST_CHECK(static_cast<Position*>(storage.get(other, 0))->x == 3.0f);
+}
+
+int main()
+{
+    Coordinator coordinator;
+    coordinator.init();
+
+    coordinator.register_component<Position>();
+
+    auto moving_system = coordinator.register_system<MovingSystem>();
+    {
+        ecs::ECSMask mask;
+        mask.set(coordinator.get_component_type<Position>());
+        coordinator.set_system_mask<MovingSystem>(mask);
+    }
+
+    coordinator.register_system<MasklessSystem>();
+
+    // The index of a destroyed entity is recycled by the next one
+    ecs::ECSEntity stale = coordinator.create_entity();
+    coordinator.add_component(stale, Position { 1.0f });
+    coordinator.destroy_entity(stale);
+
+    ecs::ECSEntity live = coordinator.create_entity();
+    coordinator.add_component(live, Position { 2.0f });
+
+    TEST_CHECK(ecs::entity_index(live) == ecs::entity_index(stale));
+
+    coordinator.destroy_entity(stale);
+    coordinator.destroy_entities(std::vector<ecs::ECSEntity> { stale, stale });
+
+    TEST_CHECK(coordinator.is_alive(live));
+    TEST_CHECK(coordinator.get_entity_count() == 1);
+    TEST_CHECK(coordinator.has_component<Position>(live));
+    TEST_CHECK(coordinator.get_component<Position>(live).x == 2.0f);
+    TEST_CHECK(moving_system->entities_.size() == 1);
+
+    // A handle listed twice in a batch frees its index once: the next two
+    // entities get different indices
+    coordinator.destroy_entities(std::vector<ecs::ECSEntity> { live, live });
+
+    TEST_CHECK(coordinator.get_entity_count() == 0);
+    TEST_CHECK(moving_system->entities_.size() == 0);
+
+    ecs::ECSEntity first = coordinator.create_entity();
+    ecs::ECSEntity second = coordinator.create_entity();
+
+    TEST_CHECK(ecs::entity_index(first) != ecs::entity_index(second));
+    TEST_CHECK(coordinator.is_alive(first) && coordinator.is_alive(second));
+    TEST_CHECK(coordinator.get_entity_count() == 2);
+
+    batch();
+    archetype_locations();
+
+    return EXIT_SUCCESS;
+}
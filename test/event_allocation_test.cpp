@@ -0,0 +1,129 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "event.hpp"
+#include "event_delegate.hpp"
+#include "event_manager.hpp"
+#include "event_types.hpp"
+
+#include "test_check.hpp"
+
+// Sending, posting and dispatching events must not touch the heap once the
+// listeners are subscribed and the frame queue has reached its size.
+
+static std::atomic<std::size_t> allocations{0};
+
+void* operator new(std::size_t size)
+{
+    ++allocations;
+
+    if (void* pointer = std::malloc(size ? size : 1))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    ++allocations;
+
+    std::size_t align = static_cast<std::size_t>(alignment);
+    if (void* pointer = std::aligned_alloc(align, (size + align - 1) / align * align))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { std::free(pointer); }
+
+using namespace engine::event;
+
+struct Listener
+{
+    double mouse = 0.0;
+    double scroll = 0.0;
+    int resizes = 0;
+    int quits = 0;
+
+    void mouse_position_handler(Event& event)
+    {
+        MousePositionEvent position = event.get<MousePositionEvent>();
+        mouse += position.x + position.y;
+    }
+
+    void scroll_offset_handler(Event& event)
+    {
+        scroll += event.get<ScrollOffsetEvent>().y;
+    }
+
+    void resize_handler(Event& event)
+    {
+        resizes += event.get<ResizeEvent>().width > 0;
+    }
+
+    void quit_handler(Event&)
+    {
+        ++quits;
+    }
+};
+
+// One frame of input: events sent right away, a burst of posted events
+// coalescing down to one per type, then the dispatch
+static void frame(EventManager& manager, int i)
+{
+    Event resize(ResizeEvent { 1280 + i, 720 });
+    manager.send_event(resize);
+    manager.send_event(QUIT);
+
+    for (int j = 0; j < 16; ++j)
+    {
+        TEST_CHECK(manager.post_event(Event(MousePositionEvent { double(i), double(j) })));
+        TEST_CHECK(manager.post_event(Event(ScrollOffsetEvent { 0.0, 1.0 })));
+    }
+
+    TEST_CHECK(manager.post_event(Event(ResizeEvent { 800, 600 })));
+
+    manager.dispatch_events();
+}
+
+int main()
+{
+    constexpr int FRAMES = 10000;
+
+    EventManager manager;
+    manager.coalesce_replace<MousePositionEvent>();
+    manager.coalesce_accumulate<ScrollOffsetEvent>();
+
+    Listener listener;
+    EventListener mouse = manager.add_listener(MOUSE_POSITION, EventDelegate::bind<&Listener::mouse_position_handler>(&listener));
+    EventListener scroll = manager.add_listener(SCROLL_OFFSET, EventDelegate::bind<&Listener::scroll_offset_handler>(&listener));
+    EventListener resize = manager.add_listener(RESIZE, EventDelegate::bind<&Listener::resize_handler>(&listener));
+    EventListener quit = manager.add_listener(QUIT, EventDelegate::bind<&Listener::quit_handler>(&listener));
+
+    // The first frame sizes the frame queue
+    frame(manager, 0);
+
+    std::size_t before = allocations.load();
+
+    for (int i = 1; i <= FRAMES; ++i)
+        frame(manager, i);
+
+    std::size_t during = allocations.load() - before;
+
+    std::cout << during << " allocations over " << FRAMES << " frames" << std::endl;
+
+    TEST_CHECK(during == 0);
+
+    // Every event was delivered: one coalesced scroll of 16 per frame, one
+    // sent and one posted resize per frame
+    TEST_CHECK(listener.scroll == 16.0 * (FRAMES + 1));
+    TEST_CHECK(listener.resizes == 2 * (FRAMES + 1));
+    TEST_CHECK(listener.quits == FRAMES + 1);
+
+    return EXIT_SUCCESS;
+}
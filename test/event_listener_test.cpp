@@ -0,0 +1,113 @@
+#include <cstdlib>
+#include <memory>
+#include <utility>
+
+#include "event.hpp"
+#include "event_delegate.hpp"
+#include "event_manager.hpp"
+#include "event_types.hpp"
+
+#include "test_check.hpp"
+
+// Subscription handles: unsubscribing from inside a callback, during a send,
+// moving handles around, and handles outliving their manager.
+
+using namespace engine::event;
+
+struct Listener
+{
+    int calls = 0;
+    // Reset from inside the callback
+    EventListener* unsubscribe = nullptr;
+
+    void handler(Event&)
+    {
+        ++calls;
+
+        if (unsubscribe)
+            unsubscribe->reset();
+    }
+};
+
+static void unsubscribe_in_callback()
+{
+    EventManager manager;
+
+    Listener first, second, third;
+    EventListener first_handle = manager.add_listener(QUIT, EventDelegate::bind<&Listener::handler>(&first));
+    EventListener second_handle = manager.add_listener(QUIT, EventDelegate::bind<&Listener::handler>(&second));
+    EventListener third_handle = manager.add_listener(QUIT, EventDelegate::bind<&Listener::handler>(&third));
+
+    // The first unsubscribes itself, the second the third - not called any more
+    first.unsubscribe = &first_handle;
+    second.unsubscribe = &third_handle;
+
+    manager.send_event(QUIT);
+
+    TEST_CHECK(first.calls == 1 && second.calls == 1 && third.calls == 0);
+    TEST_CHECK(!first_handle.is_subscribed() && second_handle.is_subscribed() && !third_handle.is_subscribed());
+
+    second.unsubscribe = nullptr;
+    manager.send_event(QUIT);
+
+    TEST_CHECK(first.calls == 1 && second.calls == 2 && third.calls == 0);
+
+    // Subscribing again once unsubscribed
+    first.unsubscribe = nullptr;
+    first_handle = manager.add_listener(QUIT, EventDelegate::bind<&Listener::handler>(&first));
+    manager.send_event(QUIT);
+
+    TEST_CHECK(first.calls == 2 && second.calls == 3);
+}
+
+static void moved_handles()
+{
+    EventManager manager;
+
+    Listener listener;
+    EventListener handle = manager.add_listener(QUIT, EventDelegate::bind<&Listener::handler>(&listener));
+
+    EventListener moved = std::move(handle);
+    TEST_CHECK(!handle.is_subscribed() && moved.is_subscribed());
+
+    // The moved-from handle no longer owns the subscription
+    handle.reset();
+    manager.send_event(QUIT);
+    TEST_CHECK(listener.calls == 1);
+
+    {
+        EventListener scoped = std::move(moved);
+    }
+
+    manager.send_event(QUIT);
+    TEST_CHECK(listener.calls == 1);
+}
+
+static void outliving_manager()
+{
+    auto manager = std::make_unique<EventManager>();
+
+    Listener listener;
+    EventListener reset_handle = manager->add_listener(QUIT, EventDelegate::bind<&Listener::handler>(&listener));
+    EventListener moved_handle = manager->add_listener(RESIZE, EventDelegate::bind<&Listener::handler>(&listener));
+    auto destroyed_handle = std::make_unique<EventListener>(manager->add_listener(MOUSE_POSITION, EventDelegate::bind<&Listener::handler>(&listener)));
+
+    manager.reset();
+
+    TEST_CHECK(!reset_handle.is_subscribed());
+
+    // None of them reaches the destroyed manager (AddressSanitizer would say)
+    reset_handle.reset();
+    EventListener moved = std::move(moved_handle);
+    TEST_CHECK(!moved.is_subscribed());
+    destroyed_handle.reset();
+}
+
+int main()
+{
+    unsubscribe_in_callback();
+    moved_handles();
+    outliving_manager();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,114 @@
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "event.hpp"
+#include "event_delegate.hpp"
+#include "event_manager.hpp"
+#include "event_recording.hpp"
+#include "event_types.hpp"
+
+#include "test_check.hpp"
+
+// Threads posting while the engine thread closes frames, the way Engine
+// records them: every frame of the recording holds exactly the events the
+// following dispatch delivered, and a dropped event is not recorded.
+// Meant to be run under ThreadSanitizer as well.
+
+using namespace engine::event;
+
+struct Counter
+{
+    std::size_t delivered = 0;
+
+    void handler(Event&)
+    {
+        ++delivered;
+    }
+};
+
+int main()
+{
+    constexpr std::size_t POSTERS = 4;
+    constexpr std::size_t FRAMES = 2000;
+    constexpr std::size_t EVENTS = 100000;
+
+    EventManager manager;
+    EventRecording recording;
+
+    Counter counter;
+    EventListener listener = manager.add_listener(MOUSE_POSITION, EventDelegate::bind<&Counter::handler>(&counter));
+
+    std::atomic<bool> done{false};
+    std::vector<std::thread> posters;
+
+    for (std::size_t i = 0; i < POSTERS; ++i)
+    {
+        posters.emplace_back([&]()
+        {
+            Event event(MousePositionEvent { 1.0, 2.0 });
+
+            while (!done.load(std::memory_order_relaxed))
+            {
+                recording.record(event, EventRecording::Delivery::POSTED, [&]()
+                {
+                    return manager.post_event(event);
+                });
+
+                std::this_thread::yield();
+            }
+        });
+    }
+
+    // Delivered by the dispatch following each end_frame
+    std::vector<std::size_t> delivered;
+
+    while (delivered.size() < FRAMES || counter.delivered < EVENTS)
+    {
+        recording.end_frame(1.0f / 60.0f, [&]()
+        {
+            manager.collect_events();
+        });
+
+        std::size_t before = counter.delivered;
+        manager.dispatch_events();
+        delivered.push_back(counter.delivered - before);
+
+        std::this_thread::yield();
+    }
+
+    done.store(true, std::memory_order_relaxed);
+    for (std::thread& poster : posters)
+        poster.join();
+
+    TEST_CHECK(recording.get_frame_count() == delivered.size());
+
+    for (std::size_t frame = 0; frame < delivered.size(); ++frame)
+    {
+        std::size_t recorded = 0;
+        recording.each_event(frame, [&](Event const&, EventRecording::Delivery delivery)
+        {
+            TEST_CHECK(delivery == EventRecording::Delivery::POSTED);
+            ++recorded;
+        });
+
+        TEST_CHECK(recorded == delivered[frame]);
+    }
+
+    // A full queue drops the event and its record
+    EventManager full;
+    Event event(QUIT);
+    while (full.post_event(event))
+        ;
+
+    EventRecording dropped;
+    TEST_CHECK(!dropped.record(event, EventRecording::Delivery::POSTED, [&]() { return full.post_event(event); }));
+    dropped.end_frame(0.0f);
+
+    std::size_t recorded = 0;
+    dropped.each_event(0, [&](Event const&, EventRecording::Delivery) { ++recorded; });
+    TEST_CHECK(recorded == 0);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,110 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "utils_job_system.hpp"
+
+#include "test_check.hpp"
+
+using namespace engine::utils;
+
+// Workers sleep while the only queued job waits for its dependency
+static void test_blocked_job_does_not_spin()
+{
+    JobSystem job_system(3);
+
+    JobCounter gate(1);
+    JobCounter done;
+    std::atomic<bool> ran{false};
+
+    job_system.schedule([&]() { ran = true; }, &done, &gate);
+
+    std::clock_t cpu_start = std::clock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    double cpu_ms = 1000.0 * double(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+
+    std::cout << "CPU time with a blocked job: " << cpu_ms << "ms over 300ms" << std::endl;
+
+    TEST_CHECK(!ran);
+    TEST_CHECK(cpu_ms < 30.0);
+
+    job_system.decrement(gate);
+    job_system.wait(done);
+
+    TEST_CHECK(ran);
+}
+
+// A chain of jobs, each released by the previous one, runs in order
+static void test_dependency_chain(std::size_t nb_workers)
+{
+    constexpr std::size_t LENGTH = 200;
+
+    JobSystem job_system(nb_workers);
+
+    std::vector<std::unique_ptr<JobCounter>> pending;
+    for (std::size_t i = 0; i < LENGTH; ++i)
+        pending.push_back(std::make_unique<JobCounter>(i == 0 ? 0 : 1));
+
+    JobCounter done;
+    std::vector<std::size_t> order;
+    std::mutex order_mutex;
+
+    // Scheduled last to first, so only the dependencies give the order
+    for (std::size_t i = LENGTH; i-- > 0;)
+    {
+        job_system.schedule([&, i]()
+        {
+            {
+                std::lock_guard<std::mutex> lock(order_mutex);
+                order.push_back(i);
+            }
+
+            if (i + 1 < LENGTH)
+                job_system.decrement(*pending[i + 1]);
+        }, &done, pending[i].get());
+    }
+
+    job_system.wait(done);
+
+    TEST_CHECK(order.size() == LENGTH);
+    for (std::size_t i = 0; i < LENGTH; ++i)
+        TEST_CHECK(order[i] == i);
+}
+
+static void test_parallel_for(std::size_t nb_workers)
+{
+    JobSystem job_system(nb_workers);
+
+    std::vector<std::uint64_t> values(100000);
+
+    job_system.parallel_for(0, values.size(), 1000, [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+            values[i] = i;
+    });
+
+    std::uint64_t sum = 0;
+    for (std::uint64_t value : values)
+        sum += value;
+
+    TEST_CHECK(sum == std::uint64_t(values.size()) * (values.size() - 1) / 2);
+}
+
+int main()
+{
+    test_blocked_job_does_not_spin();
+
+    for (std::size_t nb_workers : { 0, 1, 3, 8 })
+    {
+        test_dependency_chain(nb_workers);
+        test_parallel_for(nb_workers);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,133 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "utils_mpsc_ring.hpp"
+
+#include "test_check.hpp"
+
+// Producers racing on a small ring, wrapping around it many times: every
+// value comes out exactly once, in the order its producer pushed it. Meant to
+// be run under ThreadSanitizer as well.
+
+using engine::utils::MPSCRing;
+
+// Counts the live copies, to check the ring destroys what it holds
+struct Tracked
+{
+    static inline std::atomic<int> alive{0};
+
+    Tracked() { ++alive; }
+    Tracked(Tracked const&) { ++alive; }
+    Tracked& operator=(Tracked const&) = default;
+    ~Tracked() { --alive; }
+};
+
+static void single_thread()
+{
+    MPSCRing<int> ring(4);
+    TEST_CHECK(ring.capacity() == 4);
+
+    int value = 0;
+    TEST_CHECK(!ring.try_pop(value));
+
+    for (int i = 0; i < 4; ++i)
+        TEST_CHECK(ring.try_push(i));
+
+    // Full: rejected without being stored
+    TEST_CHECK(!ring.try_push(4));
+
+    TEST_CHECK(ring.try_pop(value) && value == 0);
+    TEST_CHECK(ring.try_push(4));
+
+    int expected = 1;
+    TEST_CHECK(ring.drain([&](int& popped) { TEST_CHECK(popped == expected++); }) == 4);
+    TEST_CHECK(!ring.try_pop(value));
+
+    {
+        MPSCRing<Tracked> tracked(8);
+        for (int i = 0; i < 5; ++i)
+            TEST_CHECK(tracked.try_push(Tracked()));
+
+        Tracked popped;
+        TEST_CHECK(tracked.try_pop(popped));
+        TEST_CHECK(Tracked::alive == 5);
+    }
+
+    // Values left in the ring are destroyed with it
+    TEST_CHECK(Tracked::alive == 0);
+}
+
+static void producers(std::size_t producer_count)
+{
+    constexpr std::uint32_t VALUES = 200000;
+
+    MPSCRing<std::uint64_t> ring(64);
+
+    std::atomic<std::size_t> full{0};
+    std::vector<std::thread> threads;
+
+    for (std::size_t producer = 0; producer < producer_count; ++producer)
+    {
+        threads.emplace_back([&, producer]()
+        {
+            for (std::uint32_t i = 0; i < VALUES; ++i)
+            {
+                // Producer in the high half, its sequence in the low half
+                std::uint64_t value = (std::uint64_t(producer) << 32) | i;
+
+                while (!ring.try_push(value))
+                {
+                    ++full;
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Next sequence expected from every producer
+    std::vector<std::uint32_t> next(producer_count, 0);
+    std::size_t popped = 0;
+
+    while (popped < producer_count * VALUES)
+    {
+        std::size_t drained = ring.drain([&](std::uint64_t& value)
+        {
+            std::size_t producer = static_cast<std::size_t>(value >> 32);
+            std::uint32_t sequence = static_cast<std::uint32_t>(value);
+
+            TEST_CHECK(producer < producer_count);
+            TEST_CHECK(sequence == next[producer]);
+
+            ++next[producer];
+        });
+
+        popped += drained;
+
+        if (drained == 0)
+            std::this_thread::yield();
+    }
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    std::uint64_t value = 0;
+    TEST_CHECK(!ring.try_pop(value));
+
+    for (std::uint32_t count : next)
+        TEST_CHECK(count == VALUES);
+
+    std::cout << producer_count << " producers: " << full.load() << " pushes found the ring full" << std::endl;
+}
+
+int main()
+{
+    single_thread();
+
+    for (std::size_t producer_count : { 1, 2, 4, 8 })
+        producers(producer_count);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "coordinator.hpp"
+
+#include "test_check.hpp"
+
+// Observers get one batch per dispatch with every entity a component was
+// added to, removed from or changed on since the last one. Additions of
+// entities destroyed (or stripped of the component) before the dispatch are
+// dropped, what observers do to the world lands in the next batch, and
+// changes are counted from the tick the observer was registered at.
+
+using namespace engine;
+
+struct Position
+{
+    float x = 0.0f;
+};
+
+struct Velocity
+{
+    float x = 0.0f;
+};
+
+// Every batch an observer was called with
+struct Batches
+{
+    std::vector<std::vector<ecs::ECSEntity>> batches;
+
+    ecs::ECSObserver observer()
+    {
+        return [this](ecs::ECSEntity const* entities, std::size_t count)
+        {
+            batches.emplace_back(entities, entities + count);
+        };
+    }
+
+    // The single batch received since the last call, sorted
+    std::vector<ecs::ECSEntity> take()
+    {
+        TEST_CHECK(batches.size() <= 1);
+
+        std::vector<ecs::ECSEntity> batch = batches.empty() ? std::vector<ecs::ECSEntity>() : batches.front();
+        std::sort(batch.begin(), batch.end());
+        batches.clear();
+
+        return batch;
+    }
+};
+
+static std::vector<ecs::ECSEntity> sorted(std::vector<ecs::ECSEntity> entities)
+{
+    std::sort(entities.begin(), entities.end());
+
+    return entities;
+}
+
+int main()
+{
+    Coordinator coordinator;
+    coordinator.init();
+
+    coordinator.register_component<Position>();
+    coordinator.register_component<Velocity>();
+
+    std::vector<ecs::ECSEntity> entities = coordinator.create_entities(6);
+    for (ecs::ECSEntity entity : entities)
+        coordinator.add_component(entity, Position { 1.0f });
+
+    // Changes made before registering are not reported
+    coordinator.enable_change_tracking<Position>();
+    coordinator.mark_changed<Position>(entities[0]);
+
+    Batches added, removed, changed, velocities;
+    coordinator.on_add<Position>(added.observer());
+    coordinator.on_remove<Position>(removed.observer());
+    coordinator.on_change<Position>(changed.observer());
+    coordinator.on_add<Velocity>(velocities.observer());
+
+    coordinator.dispatch_observers();
+    TEST_CHECK(added.batches.empty() && removed.batches.empty() && changed.batches.empty());
+
+    // Batched: one call per event for all the entities
+    ecs::ECSEntity fresh = coordinator.create_entity();
+    ecs::ECSEntity other = coordinator.create_entity();
+    coordinator.add_component(fresh, Position { 2.0f });
+    coordinator.add_component(other, Position { 3.0f });
+    coordinator.remove_component<Position>(entities[1]);
+    coordinator.destroy_entity(entities[2]);
+    coordinator.mark_changed<Position>(entities[3]);
+    coordinator.mark_changed<Position>(entities[4]);
+
+    coordinator.dispatch_observers();
+    TEST_CHECK(added.take() == sorted({ fresh, other }));
+    TEST_CHECK(removed.take() == sorted({ entities[1], entities[2] }));
+    // Additions are changes too
+    TEST_CHECK(changed.take() == sorted({ fresh, other, entities[3], entities[4] }));
+
+    // Nothing happened since the last dispatch
+    coordinator.dispatch_observers();
+    TEST_CHECK(added.batches.empty() && removed.batches.empty() && changed.batches.empty());
+
+    // Additions of entities gone before the dispatch are dropped, their
+    // removals are not
+    ecs::ECSEntity destroyed = coordinator.create_entity();
+    ecs::ECSEntity stripped = coordinator.create_entity();
+    ecs::ECSEntity kept = coordinator.create_entity();
+    coordinator.add_component(destroyed, Position { 4.0f });
+    coordinator.add_component(stripped, Position { 5.0f });
+    coordinator.add_component(kept, Position { 6.0f });
+    coordinator.destroy_entity(destroyed);
+    coordinator.remove_component<Position>(stripped);
+
+    coordinator.dispatch_observers();
+    TEST_CHECK(added.take() == std::vector<ecs::ECSEntity> { kept });
+    TEST_CHECK(removed.take() == sorted({ destroyed, stripped }));
+    TEST_CHECK(changed.take() == std::vector<ecs::ECSEntity> { kept });
+
+    // Observers changing the world: the next dispatch reports it
+    coordinator.on_add<Position>([&](ecs::ECSEntity const* entities, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            coordinator.add_component(entities[i], Velocity { 1.0f });
+            coordinator.mark_changed<Position>(entities[i]);
+            coordinator.remove_component<Position>(entities[i]);
+        }
+    });
+
+    ecs::ECSEntity reacted = coordinator.create_entity();
+    coordinator.add_component(reacted, Position { 7.0f });
+
+    coordinator.dispatch_observers();
+    TEST_CHECK(added.take() == std::vector<ecs::ECSEntity> { reacted });
+    TEST_CHECK(changed.take() == std::vector<ecs::ECSEntity> { reacted });
+    TEST_CHECK(removed.batches.empty() && velocities.batches.empty());
+
+    coordinator.dispatch_observers();
+    TEST_CHECK(velocities.take() == std::vector<ecs::ECSEntity> { reacted });
+    TEST_CHECK(removed.take() == std::vector<ecs::ECSEntity> { reacted });
+    // Changed, then removed before this dispatch
+    TEST_CHECK(changed.batches.empty() && added.batches.empty());
+
+    return EXIT_SUCCESS;
+}
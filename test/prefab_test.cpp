@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "coordinator.hpp"
+#include "ecs_prefab.hpp"
+#include "ecs_system.hpp"
+
+#include "test_check.hpp"
+
+// Entities instantiated from a prefab, with either storage, own a copy of
+// every component of the prefab and its tags, have the prefab mask, join the
+// systems matching it, and are reported to ADD observers in one batch.
+
+using namespace engine;
+
+struct Position
+{
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
+struct Health
+{
+    int points = 0;
+};
+
+struct Velocity
+{
+    float x = 0.0f;
+};
+
+struct Enemy
+{
+};
+
+class MovingSystem : public ecs::ECSSystem
+{};
+
+class EnemySystem : public ecs::ECSSystem
+{};
+
+class FallingSystem : public ecs::ECSSystem
+{};
+
+static void instantiating(ecs::ECSStorageMode storage_mode)
+{
+    constexpr std::size_t COUNT = 300;
+
+    Coordinator coordinator;
+    coordinator.init(storage_mode);
+
+    coordinator.register_component<Position>();
+    coordinator.register_component<Health>();
+    coordinator.register_component<Velocity>();
+    coordinator.register_component<Enemy>();
+
+    auto moving_system = coordinator.register_system<MovingSystem>();
+    auto enemy_system = coordinator.register_system<EnemySystem>();
+    auto falling_system = coordinator.register_system<FallingSystem>();
+    {
+        ecs::ECSMask mask;
+        mask.set(coordinator.get_component_type<Position>());
+        coordinator.set_system_mask<MovingSystem>(mask);
+
+        mask.set(coordinator.get_component_type<Enemy>());
+        coordinator.set_system_mask<EnemySystem>(mask);
+
+        mask.reset();
+        mask.set(coordinator.get_component_type<Position>());
+        mask.set(coordinator.get_component_type<Velocity>());
+        coordinator.set_system_mask<FallingSystem>(mask);
+    }
+
+    std::vector<std::vector<ecs::ECSEntity>> positions_added, enemies_added, velocities_added;
+    coordinator.on_add<Position>([&](ecs::ECSEntity const* entities, std::size_t count)
+    {
+        positions_added.emplace_back(entities, entities + count);
+    });
+    coordinator.on_add<Enemy>([&](ecs::ECSEntity const* entities, std::size_t count)
+    {
+        enemies_added.emplace_back(entities, entities + count);
+    });
+    coordinator.on_add<Velocity>([&](ecs::ECSEntity const* entities, std::size_t count)
+    {
+        velocities_added.emplace_back(entities, entities + count);
+    });
+
+    // An entity built by hand first, which instantiating must leave alone
+    ecs::ECSEntity manual = coordinator.create_entity();
+    coordinator.add_component(manual, Position { 9.0f, 9.0f });
+    coordinator.add_component(manual, Velocity { 9.0f });
+    coordinator.dispatch_observers();
+    positions_added.clear();
+    velocities_added.clear();
+
+    ecs::ECSPrefab prefab;
+    prefab.set(Position { 1.0f, 2.0f })
+          .set(Health { 10 })
+          .set<Enemy>()
+          .set(Health { 100 });
+
+    TEST_CHECK(prefab.has<Enemy>() && !prefab.has<Velocity>());
+
+    std::vector<ecs::ECSEntity> entities = coordinator.instantiate(prefab, COUNT);
+    ecs::ECSEntity single = coordinator.instantiate(prefab);
+    entities.push_back(single);
+
+    ecs::ECSMask expected;
+    expected.set(coordinator.get_component_type<Position>());
+    expected.set(coordinator.get_component_type<Health>());
+    expected.set(coordinator.get_component_type<Enemy>());
+
+    TEST_CHECK(prefab.get_mask() == expected);
+    TEST_CHECK(coordinator.get_entity_count() == COUNT + 2);
+
+    for (ecs::ECSEntity entity : entities)
+    {
+        TEST_CHECK(coordinator.is_alive(entity));
+        TEST_CHECK(coordinator.get_component<Position>(entity).x == 1.0f);
+        TEST_CHECK(coordinator.get_component<Position>(entity).y == 2.0f);
+        TEST_CHECK(coordinator.get_component<Health>(entity).points == 100);
+        TEST_CHECK(coordinator.has_component<Enemy>(entity) && !coordinator.has_component<Velocity>(entity));
+
+        TEST_CHECK(moving_system->entities_.contains(entity));
+        TEST_CHECK(enemy_system->entities_.contains(entity));
+        TEST_CHECK(!falling_system->entities_.contains(entity));
+    }
+
+    TEST_CHECK(moving_system->entities_.size() == COUNT + 2);
+    TEST_CHECK(enemy_system->entities_.size() == COUNT + 1);
+    TEST_CHECK(falling_system->entities_.size() == 1 && falling_system->entities_.contains(manual));
+
+    // Copies: writing one instance leaves the others and the prefab alone
+    coordinator.get_component<Health>(entities[0]).points = 1;
+    TEST_CHECK(coordinator.get_component<Health>(entities[1]).points == 100);
+    TEST_CHECK(coordinator.get_component<Position>(manual).x == 9.0f);
+    TEST_CHECK(coordinator.get_component<Velocity>(manual).x == 9.0f);
+
+    // Both calls reported in one batch per observed type
+    coordinator.dispatch_observers();
+
+    std::vector<ecs::ECSEntity> reported;
+    for (auto const& batch : positions_added)
+        reported.insert(reported.end(), batch.begin(), batch.end());
+
+    std::sort(reported.begin(), reported.end());
+    std::sort(entities.begin(), entities.end());
+
+    TEST_CHECK(positions_added.size() == 1 && reported == entities);
+    TEST_CHECK(enemies_added.size() == 1 && enemies_added.front().size() == COUNT + 1);
+    TEST_CHECK(velocities_added.empty());
+
+    // Instances are ordinary entities afterwards
+    coordinator.add_component(single, Velocity { 3.0f });
+    TEST_CHECK(falling_system->entities_.contains(single));
+
+    coordinator.destroy_entity(entities[5]);
+    TEST_CHECK(moving_system->entities_.size() == COUNT + 1);
+    TEST_CHECK(enemy_system->entities_.size() == COUNT);
+}
+
+int main()
+{
+    instantiating(ecs::ECSStorageMode::SPARSE_SET);
+    instantiating(ecs::ECSStorageMode::ARCHETYPE);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,175 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ecs_scheduler.hpp"
+#include "ecs_system.hpp"
+
+#include "utils_job_system.hpp"
+
+#include "test_check.hpp"
+
+// The scheduler orders systems after every earlier system they conflict with
+// (a type written by one and read or written by the other) and lets the
+// others run side by side. Levels and predecessors come from dump, and
+// conflicting systems must never run at the same time.
+
+using namespace engine;
+
+struct Position {};
+struct Velocity {};
+struct Sound {};
+
+// Order in which the updates started and ended, over every system
+static std::atomic<int> timeline{0};
+
+class TimedSystem : public ecs::ECSSystem
+{
+    public:
+        void update(float) override
+        {
+            begin = timeline.fetch_add(1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            end = timeline.fetch_add(1);
+        }
+
+        int begin = 0;
+        int end = 0;
+};
+
+class InputSystem : public TimedSystem
+{
+    public:
+        InputSystem() { writes<Velocity>(); }
+};
+
+class AudioSystem : public TimedSystem
+{
+    public:
+        AudioSystem() { reads<Sound>(); }
+};
+
+class PhysicsSystem : public TimedSystem
+{
+    public:
+        PhysicsSystem() { reads<Velocity>(); writes<Position>(); }
+};
+
+class RenderSystem : public TimedSystem
+{
+    public:
+        RenderSystem() { reads<Position>(); }
+};
+
+class CullingSystem : public TimedSystem
+{
+    public:
+        CullingSystem() { reads<Position>(); }
+};
+
+class CleanupSystem : public TimedSystem
+{
+    public:
+        CleanupSystem() { writes<Position, Sound>(); }
+};
+
+struct Scheduled
+{
+    std::size_t level = 0;
+    std::vector<std::string> predecessors;
+};
+
+// Reads back the level and predecessors of every system from dump
+static std::map<std::string, Scheduled> parse(ecs::ECSScheduler const& scheduler)
+{
+    std::ostringstream stream;
+    scheduler.dump(stream);
+
+    std::istringstream lines(stream.str());
+    std::string line;
+    std::getline(lines, line);
+
+    std::map<std::string, Scheduled> scheduled;
+    while (std::getline(lines, line))
+    {
+        std::istringstream words(line);
+        std::string level, name, word;
+        words >> level >> name;
+
+        Scheduled& entry = scheduled[name];
+        entry.level = std::stoul(level.substr(1, level.size() - 2));
+
+        while (words >> word && word != "after")
+            ;
+        while (words >> word)
+            entry.predecessors.push_back(word);
+    }
+
+    return scheduled;
+}
+
+int main()
+{
+    utils::JobSystem job_system(4);
+    ecs::ECSScheduler scheduler;
+
+    auto input = std::make_shared<InputSystem>();
+    auto audio = std::make_shared<AudioSystem>();
+    auto physics = std::make_shared<PhysicsSystem>();
+    auto render = std::make_shared<RenderSystem>();
+    auto culling = std::make_shared<CullingSystem>();
+    auto cleanup = std::make_shared<CleanupSystem>();
+
+    scheduler.add(input, "Input");
+    scheduler.add(audio, "Audio");
+    scheduler.add(physics, "Physics");
+    scheduler.add(render, "Render");
+    scheduler.add(culling, "Culling");
+    scheduler.add(cleanup, "Cleanup");
+
+    // Every earlier system conflicting with a later one, by registration order
+    std::vector<std::pair<TimedSystem*, TimedSystem*>> conflicts = {
+        { input.get(), physics.get() },     // write-read on Velocity
+        { physics.get(), render.get() },    // write-read on Position
+        { physics.get(), culling.get() },
+        { audio.get(), cleanup.get() },     // read-write on Sound
+        { physics.get(), cleanup.get() },   // write-write on Position
+        { render.get(), cleanup.get() },
+        { culling.get(), cleanup.get() },
+    };
+
+    for (int frame = 0; frame < 20; ++frame)
+    {
+        scheduler.run(job_system, 1.0f / 60.0f);
+
+        // The earlier system of a conflicting pair always ends first
+        for (auto const& [first, second] : conflicts)
+            TEST_CHECK(first->end < second->begin);
+    }
+
+    std::map<std::string, Scheduled> scheduled = parse(scheduler);
+    TEST_CHECK(scheduled.size() == 6);
+
+    // Disjoint masks and read-read sharing add no edge
+    TEST_CHECK(scheduled["Input"].level == 0 && scheduled["Input"].predecessors.empty());
+    TEST_CHECK(scheduled["Audio"].level == 0 && scheduled["Audio"].predecessors.empty());
+
+    TEST_CHECK(scheduled["Physics"].level == 1);
+    TEST_CHECK(scheduled["Physics"].predecessors == std::vector<std::string>({ "Input" }));
+
+    TEST_CHECK(scheduled["Render"].level == 2);
+    TEST_CHECK(scheduled["Render"].predecessors == std::vector<std::string>({ "Physics" }));
+    TEST_CHECK(scheduled["Culling"].level == 2);
+    TEST_CHECK(scheduled["Culling"].predecessors == std::vector<std::string>({ "Physics" }));
+
+    TEST_CHECK(scheduled["Cleanup"].level == 3);
+    TEST_CHECK(scheduled["Cleanup"].predecessors == std::vector<std::string>({ "Audio", "Physics", "Render", "Culling" }));
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,236 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "coordinator.hpp"
+#include "ecs_snapshot.hpp"
+
+#include "utils_hash.hpp"
+
+#include "test_check.hpp"
+
+// A snapshot loads back as it was saved, also in a process handing out type
+// IDs in another order, and a corrupted one - whatever part of it is off - is
+// rejected before the world is touched.
+
+using namespace engine;
+
+struct Position
+{
+    float x = 0.0f;
+};
+
+// Same size as Position, so that only the hashes tell their sections apart
+struct Velocity
+{
+    float x = 0.0f;
+};
+
+struct Frozen
+{
+};
+
+// The same types in a build registering them in another order: other IDs
+namespace reordered
+{
+    struct Position
+    {
+        float x = 0.0f;
+    };
+
+    struct Velocity
+    {
+        float x = 0.0f;
+    };
+
+    struct Frozen
+    {
+    };
+}
+
+// Mirrors the layout written by ECSSnapshot
+struct Header
+{
+    char magic[8];
+    std::uint32_t format_version;
+    std::uint32_t entity_slots;
+    std::uint32_t free_count;
+    std::uint32_t section_count;
+    std::uint32_t type_bits;
+    std::uint32_t padding;
+
+    std::uint64_t versions;
+    std::uint64_t masks;
+    std::uint64_t free_indices;
+    std::uint64_t types;
+    std::uint64_t sections;
+};
+
+struct Section
+{
+    std::uint32_t hash;
+    std::uint32_t component_size;
+    std::uint32_t count;
+    std::uint32_t padding;
+
+    std::uint64_t entities;
+    std::uint64_t components;
+};
+
+// Element i of a blob of T starting at offset
+template<typename T>
+static T* at(std::vector<std::byte>& data, std::uint64_t offset, std::size_t i = 0)
+{
+    return reinterpret_cast<T*>(data.data() + offset) + i;
+}
+
+// Loads saved in a coordinator whose types got other IDs, in another order
+static void load_reordered(Coordinator& saving, std::vector<std::byte> const& saved, std::vector<ecs::ECSEntity> const& entities)
+{
+    Coordinator coordinator;
+    coordinator.init();
+
+    coordinator.register_component<reordered::Frozen>();
+    coordinator.register_component<reordered::Velocity>();
+    coordinator.register_component<reordered::Position>();
+
+    TEST_CHECK(coordinator.get_component_type<reordered::Position>() != saving.get_component_type<Position>());
+    TEST_CHECK(coordinator.get_component_type<reordered::Frozen>() != saving.get_component_type<Frozen>());
+
+    ecs::ECSSnapshot snapshot;
+    snapshot.add<reordered::Frozen>("Frozen"_hash);
+    snapshot.add<reordered::Velocity>("Velocity"_hash);
+    snapshot.add<reordered::Position>("Position"_hash);
+
+    TEST_CHECK(coordinator.load_snapshot(snapshot, saved.data(), saved.size()));
+    TEST_CHECK(coordinator.get_entity_count() == 6);
+
+    for (std::size_t i = 0; i < entities.size(); ++i)
+    {
+        if (i == 2 || i == 5)
+        {
+            TEST_CHECK(!coordinator.is_alive(entities[i]));
+            continue;
+        }
+
+        TEST_CHECK(coordinator.get_component<reordered::Position>(entities[i]).x == float(i));
+        TEST_CHECK(coordinator.get_component<reordered::Velocity>(entities[i]).x == float(-int(i)));
+        TEST_CHECK(coordinator.has_component<reordered::Frozen>(entities[i]) == (i % 2 == 1));
+    }
+
+    // A build missing one of the saved types cannot tell what its bit meant
+    ecs::ECSSnapshot partial;
+    partial.add<reordered::Velocity>("Velocity"_hash);
+    partial.add<reordered::Position>("Position"_hash);
+
+    Coordinator other;
+    other.init();
+    other.register_component<reordered::Velocity>();
+    other.register_component<reordered::Position>();
+
+    TEST_CHECK(!other.load_snapshot(partial, saved.data(), saved.size()));
+}
+
+int main()
+{
+    Coordinator coordinator;
+    coordinator.init();
+
+    coordinator.register_component<Position>();
+    coordinator.register_component<Velocity>();
+    coordinator.register_component<Frozen>();
+
+    ecs::ECSSnapshot snapshot;
+    snapshot.add<Position>("Position"_hash);
+    snapshot.add<Velocity>("Velocity"_hash);
+    snapshot.add<Frozen>("Frozen"_hash);
+
+    std::vector<ecs::ECSEntity> entities;
+    for (int i = 0; i < 8; ++i)
+    {
+        ecs::ECSEntity entity = coordinator.create_entity();
+        coordinator.add_component(entity, Position { float(i) });
+        coordinator.add_component(entity, Velocity { float(-i) });
+        if (i % 2 == 1)
+            coordinator.add_component<Frozen>(entity);
+        entities.push_back(entity);
+    }
+
+    // Two free indices
+    coordinator.destroy_entity(entities[2]);
+    coordinator.destroy_entity(entities[5]);
+
+    std::vector<std::byte> saved;
+    coordinator.save_snapshot(snapshot, saved);
+
+    // Changed after saving, to tell a load from a rejection
+    coordinator.get_component<Position>(entities[0]).x = 100.0f;
+
+    auto rejected = [&](std::function<void(std::vector<std::byte>&)> const& corrupt)
+    {
+        std::vector<std::byte> data = saved;
+        corrupt(data);
+
+        bool loaded = coordinator.load_snapshot(snapshot, data.data(), data.size());
+
+        return !loaded
+            && coordinator.get_entity_count() == 6
+            && coordinator.get_component<Position>(entities[0]).x == 100.0f;
+    };
+
+    Header header;
+    std::memcpy(&header, saved.data(), sizeof(Header));
+
+    auto section = [&](std::vector<std::byte>& data, std::size_t i)
+    {
+        return at<Section>(data, header.sections, i);
+    };
+
+    TEST_CHECK(header.entity_slots == 8 && header.free_count == 2 && header.section_count == 2);
+
+    // Free list: out of range, listed twice, or a living entity
+    TEST_CHECK(rejected([&](auto& data) { *at<ecs::ECSEntityIndex>(data, header.free_indices) = 8; }));
+    TEST_CHECK(rejected([&](auto& data) { *at<ecs::ECSEntityIndex>(data, header.free_indices, 1) = *at<ecs::ECSEntityIndex>(data, header.free_indices); }));
+    TEST_CHECK(rejected([&](auto& data) { *at<ecs::ECSEntityIndex>(data, header.free_indices) = 0; }));
+
+    // Masks holding bits of no saved type
+    TEST_CHECK(rejected([&](auto& data) { *at<std::uint32_t>(data, header.masks) |= 1u << 31; }));
+
+    // Type table: an unknown hash, or two bits naming the same type
+    std::uint32_t frozen = coordinator.get_component_type<Frozen>();
+    std::uint32_t position = coordinator.get_component_type<Position>();
+    TEST_CHECK(rejected([&](auto& data) { *at<std::uint32_t>(data, header.types, frozen) = "Unknown"_hash; }));
+    TEST_CHECK(rejected([&](auto& data) { *at<std::uint32_t>(data, header.types, frozen) = *at<std::uint32_t>(data, header.types, position); }));
+
+    // Section entities: out of range, listed twice, stale, or missing the mask bit
+    TEST_CHECK(rejected([&](auto& data) { *at<ecs::ECSEntity>(data, section(data, 0)->entities) = ecs::make_entity(8, 0); }));
+    TEST_CHECK(rejected([&](auto& data) { *at<ecs::ECSEntity>(data, section(data, 0)->entities, 1) = *at<ecs::ECSEntity>(data, section(data, 0)->entities); }));
+    TEST_CHECK(rejected([&](auto& data) { *at<ecs::ECSEntity>(data, section(data, 0)->entities) = ecs::make_entity(0, 1); }));
+    TEST_CHECK(rejected([&](auto& data) { *at<std::uint32_t>(data, header.masks) &= ~(1u << coordinator.get_component_type<Position>()); }));
+
+    // An owner left out of its section
+    TEST_CHECK(rejected([&](auto& data) { --section(data, 0)->count; }));
+
+    // Two sections of the same type
+    TEST_CHECK(rejected([&](auto& data) { section(data, 1)->hash = section(data, 0)->hash; }));
+
+    // Blobs off their alignment
+    TEST_CHECK(rejected([&](auto& data) { at<Header>(data, 0)->masks += sizeof(std::uint32_t); }));
+    TEST_CHECK(rejected([&](auto& data) { at<Header>(data, 0)->types += sizeof(std::uint32_t); }));
+    TEST_CHECK(rejected([&](auto& data) { section(data, 1)->components += sizeof(float); }));
+
+    // The untouched snapshot loads
+    TEST_CHECK(coordinator.load_snapshot(snapshot, saved.data(), saved.size()));
+    TEST_CHECK(coordinator.get_entity_count() == 6);
+    TEST_CHECK(coordinator.get_component<Position>(entities[0]).x == 0.0f);
+    TEST_CHECK(coordinator.get_component<Velocity>(entities[7]).x == -7.0f);
+    TEST_CHECK(!coordinator.is_alive(entities[5]));
+    TEST_CHECK(coordinator.has_component<Frozen>(entities[7]) && !coordinator.has_component<Frozen>(entities[6]));
+
+    load_reordered(coordinator, saved, entities);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "ecs_state_history.hpp"
+
+#include "test_check.hpp"
+
+// Every state of the history rebuilds byte for byte, whatever changed between
+// them: a few values, every value, or the size of the state. Rewinding keeps
+// the older states and forgets the newer ones, and the history never holds
+// more than its capacity of whole states.
+
+using engine::ecs::ECSStateHistory;
+
+using State = std::vector<std::byte>;
+
+// Moves every float of a state a little, keeping most of its exponents equal
+static State moved(State const& state, float step)
+{
+    State next = state;
+
+    for (std::size_t offset = 0; offset + sizeof(float) <= next.size(); offset += sizeof(float))
+    {
+        float value;
+        std::memcpy(&value, next.data() + offset, sizeof(float));
+        value += step;
+        std::memcpy(next.data() + offset, &value, sizeof(float));
+    }
+
+    return next;
+}
+
+static State floats(std::size_t count, float first)
+{
+    State state(count * sizeof(float));
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        float value = first + float(i);
+        std::memcpy(state.data() + i * sizeof(float), &value, sizeof(float));
+    }
+
+    return state;
+}
+
+// Every state of the history is the one pushed frames_back pushes ago
+static void check_all(ECSStateHistory const& history, std::vector<State> const& pushed)
+{
+    TEST_CHECK(history.size() == std::min(pushed.size(), history.capacity()));
+
+    State out;
+    for (std::size_t frames_back = 0; frames_back < history.size(); ++frames_back)
+    {
+        TEST_CHECK(history.get(frames_back, out));
+        TEST_CHECK(out == pushed[pushed.size() - 1 - frames_back]);
+    }
+
+    TEST_CHECK(!history.get(history.size(), out));
+}
+
+static void sparse_changes()
+{
+    std::mt19937 random(3);
+
+    ECSStateHistory history(8);
+    std::vector<State> pushed;
+
+    State state = floats(1000, 0.0f);
+    for (std::size_t frame = 0; frame < 20; ++frame)
+    {
+        // A few values change in place, sometimes next to each other
+        for (int i = 0; i < 5; ++i)
+            state[random() % state.size()] = std::byte(random());
+
+        pushed.push_back(state);
+        history.push(state);
+
+        check_all(history, pushed);
+    }
+
+    // Deltas of a few changed bytes cost a fraction of a state
+    TEST_CHECK(history.get_memory_usage() < 2 * state.size());
+}
+
+static void every_value_changes()
+{
+    ECSStateHistory history(8);
+    std::vector<State> pushed;
+
+    State state = floats(1000, 100.0f);
+    for (std::size_t frame = 0; frame < 20; ++frame)
+    {
+        state = moved(state, 0.25f);
+
+        pushed.push_back(state);
+        history.push(state);
+
+        check_all(history, pushed);
+
+        // Never more than capacity whole states
+        TEST_CHECK(history.get_memory_usage() <= history.capacity() * state.size());
+    }
+}
+
+static void sizes_change()
+{
+    ECSStateHistory history(6);
+    std::vector<State> pushed;
+
+    // Growing, shrinking, empty and back
+    for (std::size_t count : { 10, 40, 40, 5, 0, 0, 30, 12, 64 })
+    {
+        State state = floats(count, float(count));
+
+        pushed.push_back(state);
+        history.push(state);
+
+        check_all(history, pushed);
+    }
+}
+
+static void rewinding()
+{
+    ECSStateHistory history(8);
+    std::vector<State> pushed;
+
+    for (std::size_t frame = 0; frame < 6; ++frame)
+    {
+        pushed.push_back(floats(100 + frame * 3, float(frame)));
+        history.push(pushed.back());
+    }
+
+    // Back to 2 frames ago: the two newest states are gone
+    history.rewind(2);
+    pushed.resize(pushed.size() - 2);
+    check_all(history, pushed);
+
+    // Frames pushed after the rewind follow the state rewound to
+    pushed.push_back(moved(pushed.back(), 1.0f));
+    history.push(pushed.back());
+    check_all(history, pushed);
+
+    // Rewinding to the newest state changes nothing
+    history.rewind(0);
+    check_all(history, pushed);
+
+    history.clear();
+    TEST_CHECK(history.size() == 0);
+
+    State out;
+    TEST_CHECK(!history.get(0, out));
+}
+
+static void single_state()
+{
+    ECSStateHistory history(1);
+
+    for (std::size_t frame = 0; frame < 4; ++frame)
+    {
+        State state = floats(50, float(frame));
+        history.push(state);
+
+        TEST_CHECK(history.size() == 1);
+        check_all(history, { state });
+        TEST_CHECK(history.get_memory_usage() == state.size());
+    }
+
+    history.rewind(0);
+    check_all(history, { floats(50, 3.0f) });
+}
+
+int main()
+{
+    sparse_changes();
+    every_value_changes();
+    sizes_change();
+    rewinding();
+    single_state();
+
+    return EXIT_SUCCESS;
+}
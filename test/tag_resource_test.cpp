@@ -0,0 +1,143 @@
+#include <cstdlib>
+#include <vector>
+
+#include "coordinator.hpp"
+#include "ecs_component_manager.hpp"
+
+#include "test_check.hpp"
+
+// Tags are a bit of the entity mask with no storage, and views filter on
+// them with with<Tag>() and without<Tag>(). Resources are set, replaced and
+// removed, each replaced or removed value being destroyed.
+
+using namespace engine;
+
+struct Position
+{
+    float x = 0.0f;
+};
+
+struct Frozen
+{
+};
+
+struct Settings
+{
+    explicit Settings(int level, int* destroyed)
+        : level(level), destroyed(destroyed)
+    {}
+
+    Settings(Settings&& other)
+        : level(other.level), destroyed(other.destroyed)
+    {
+        other.destroyed = nullptr;
+    }
+
+    ~Settings()
+    {
+        if (destroyed)
+            ++*destroyed;
+    }
+
+    int level = 0;
+    int* destroyed = nullptr;
+};
+
+static void tags()
+{
+    // Registered as a tag: a mask bit, never an array
+    ecs::ECSComponentManager component_manager;
+    component_manager.register_component<Position>();
+    component_manager.register_component<Frozen>();
+
+    TEST_CHECK(component_manager.is_tag<Frozen>() && !component_manager.is_tag<Position>());
+    TEST_CHECK(component_manager.get_tag_mask() == ecs::ECSMask().set(component_manager.get_component_type<Frozen>()));
+
+    Coordinator coordinator;
+    coordinator.init();
+
+    coordinator.register_component<Position>();
+    coordinator.register_component<Frozen>();
+
+    std::vector<ecs::ECSEntity> entities = coordinator.create_entities(10);
+    for (std::size_t i = 0; i < entities.size(); ++i)
+    {
+        coordinator.add_component(entities[i], Position { float(i) });
+        if (i % 3 == 0)
+            coordinator.add_component<Frozen>(entities[i]);
+    }
+
+    // Adding and removing tags never touches the component arrays
+    auto* positions = coordinator.get_component_array<Position>();
+    std::vector<ecs::ECSEntity> order(positions->entities(), positions->entities() + positions->size());
+
+    std::uint32_t version = coordinator.get_component_version<Frozen>();
+    coordinator.remove_component<Frozen>(entities[0]);
+    coordinator.add_component<Frozen>(entities[1]);
+
+    TEST_CHECK(coordinator.get_component_version<Frozen>() == version + 2);
+    TEST_CHECK(std::vector<ecs::ECSEntity>(positions->entities(), positions->entities() + positions->size()) == order);
+    TEST_CHECK(!coordinator.has_component<Frozen>(entities[0]) && coordinator.has_component<Frozen>(entities[1]));
+
+    // Frozen now: 1, 3, 6 and 9
+    std::vector<ecs::ECSEntity> frozen, moving;
+    coordinator.view<Position>().with<Frozen>().each([&](ecs::ECSEntity entity, Position&)
+    {
+        frozen.push_back(entity);
+    });
+    coordinator.view<Position>().without<Frozen>().each([&](ecs::ECSEntity entity, Position&)
+    {
+        moving.push_back(entity);
+    });
+
+    TEST_CHECK(frozen == std::vector<ecs::ECSEntity>({ entities[1], entities[3], entities[6], entities[9] }));
+    TEST_CHECK(moving.size() == 6);
+    for (ecs::ECSEntity entity : moving)
+        TEST_CHECK(!coordinator.has_component<Frozen>(entity));
+
+    // Destroying a tagged entity clears its bit with the rest of the mask
+    coordinator.destroy_entity(entities[3]);
+    std::size_t count = 0;
+    coordinator.view<Position>().with<Frozen>().each([&](ecs::ECSEntity, Position&) { ++count; });
+    TEST_CHECK(count == 3);
+}
+
+static void resources()
+{
+    // Outlives the coordinator, which destroys the last value
+    int destroyed = 0;
+
+    Coordinator coordinator;
+    coordinator.init();
+
+    TEST_CHECK(!coordinator.has_resource<Settings>());
+
+    Settings& settings = coordinator.set_resource(Settings(1, &destroyed));
+    TEST_CHECK(coordinator.has_resource<Settings>() && &coordinator.get_resource<Settings>() == &settings);
+    TEST_CHECK(settings.level == 1);
+
+    // Writable in place
+    coordinator.get_resource<Settings>().level = 2;
+    TEST_CHECK(coordinator.get_resource<Settings>().level == 2);
+
+    // Replacing destroys the previous value
+    coordinator.set_resource(Settings(3, &destroyed));
+    TEST_CHECK(destroyed == 1);
+    TEST_CHECK(coordinator.get_resource<Settings>().level == 3);
+
+    coordinator.remove_resource<Settings>();
+    TEST_CHECK(destroyed == 2);
+    TEST_CHECK(!coordinator.has_resource<Settings>());
+
+    // And back
+    coordinator.set_resource(Settings(4, &destroyed));
+    TEST_CHECK(coordinator.has_resource<Settings>() && coordinator.get_resource<Settings>().level == 4);
+}
+
+int main()
+{
+    tags();
+    resources();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+
+// Checks for the test executables: unlike assert, they stay on in release
+// builds, and a failure ends the test with a non-zero exit code.
+#define TEST_CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+            std::exit(EXIT_FAILURE); \
+        } \
+    } while (false)
@@ -0,0 +1,136 @@
+#include <cstddef>
+#include <cstdlib>
+
+#include "coordinator.hpp"
+#include "transform_hierarchy_system.hpp"
+
+#include "test_check.hpp"
+
+// World transforms follow the parent links, a parent cycle is cut instead of
+// hanging the pass, and a change elsewhere in the world recomputes only the
+// entities it concerns.
+
+using namespace engine;
+
+static float world_x(Coordinator& coordinator, ecs::ECSEntity entity)
+{
+    return coordinator.get_component<component::WorldTransform>(entity).matrix.m[3][0];
+}
+
+// Runs a pass, returning how many world transforms it wrote
+static std::size_t update(Coordinator& coordinator, system::TransformHierarchySystem& hierarchy_system)
+{
+    // The pass moves to the next tick and records its writes at it
+    ecs::ECSTick since = coordinator.get_tick() + 1;
+    hierarchy_system.update(0.0f);
+
+    std::size_t count = 0;
+    coordinator.each_changed<component::WorldTransform>(since, [&](ecs::ECSEntity, component::WorldTransform&)
+    {
+        ++count;
+    });
+
+    return count;
+}
+
+static ecs::ECSEntity spawn(Coordinator& coordinator, float x, ecs::ECSEntity parent = ecs::NULL_ENTITY)
+{
+    ecs::ECSEntity entity = coordinator.create_entity();
+
+    component::Transform transform;
+    transform.position = Diligent::float3(x, 0, 0);
+
+    coordinator.add_component(entity, transform);
+    coordinator.add_component(entity, component::WorldTransform {});
+    coordinator.add_component(entity, component::Hierarchy { parent });
+
+    return entity;
+}
+
+int main()
+{
+    Coordinator coordinator;
+    coordinator.init();
+
+    coordinator.register_component<component::Transform>();
+    coordinator.register_component<component::Hierarchy>();
+    coordinator.register_component<component::WorldTransform>();
+    coordinator.enable_change_tracking<component::WorldTransform>();
+
+    auto hierarchy_system = coordinator.register_system<system::TransformHierarchySystem>(coordinator);
+    {
+        ecs::ECSMask mask;
+        mask.set(coordinator.get_component_type<component::Transform>());
+        mask.set(coordinator.get_component_type<component::WorldTransform>());
+        coordinator.set_system_mask<system::TransformHierarchySystem>(mask);
+    }
+    hierarchy_system->init();
+
+    // Owns the first Transform, so that removing it moves a member's
+    ecs::ECSEntity outsider = coordinator.create_entity();
+    coordinator.add_component(outsider, component::Transform {});
+
+    ecs::ECSEntity root = spawn(coordinator, 1.0f);
+    ecs::ECSEntity child = spawn(coordinator, 2.0f, root);
+    ecs::ECSEntity grandchild = spawn(coordinator, 4.0f, child);
+
+    // Two entities parented to each other: one link is ignored
+    ecs::ECSEntity first = spawn(coordinator, 8.0f);
+    ecs::ECSEntity second = spawn(coordinator, 16.0f, first);
+    coordinator.get_component<component::Hierarchy>(first).parent = second;
+    coordinator.mark_changed<component::Hierarchy>(first);
+
+    TEST_CHECK(update(coordinator, *hierarchy_system) == 5);
+
+    TEST_CHECK(world_x(coordinator, root) == 1.0f);
+    TEST_CHECK(world_x(coordinator, child) == 3.0f);
+    TEST_CHECK(world_x(coordinator, grandchild) == 7.0f);
+
+    float first_x = world_x(coordinator, first);
+    float second_x = world_x(coordinator, second);
+    TEST_CHECK((first_x == 8.0f && second_x == 24.0f) || (first_x == 24.0f && second_x == 16.0f));
+
+    // Nothing changed: nothing recomputed
+    TEST_CHECK(update(coordinator, *hierarchy_system) == 0);
+
+    // A moved parent carries its descendants along, and only them
+    coordinator.get_component<component::Transform>(child).position.x = 3.0f;
+    coordinator.mark_changed<component::Transform>(child);
+
+    TEST_CHECK(update(coordinator, *hierarchy_system) == 2);
+    TEST_CHECK(world_x(coordinator, child) == 4.0f);
+    TEST_CHECK(world_x(coordinator, grandchild) == 8.0f);
+
+    // Transforms added and removed outside the hierarchy move no world transform
+    ecs::ECSEntity extra = coordinator.create_entity();
+    coordinator.add_component(extra, component::Transform {});
+
+    TEST_CHECK(update(coordinator, *hierarchy_system) == 0);
+
+    coordinator.destroy_entity(extra);
+    coordinator.remove_component<component::Transform>(outsider);
+
+    TEST_CHECK(update(coordinator, *hierarchy_system) == 0);
+
+    // The moved Transform is still followed
+    coordinator.get_component<component::Transform>(second).position.x = 32.0f;
+    coordinator.mark_changed<component::Transform>(second);
+
+    TEST_CHECK(update(coordinator, *hierarchy_system) >= 1);
+    TEST_CHECK(world_x(coordinator, second) == 32.0f || world_x(coordinator, second) == 40.0f);
+
+    // A new member is computed on its own
+    ecs::ECSEntity leaf = spawn(coordinator, 1.0f, grandchild);
+
+    TEST_CHECK(update(coordinator, *hierarchy_system) == 1);
+    TEST_CHECK(world_x(coordinator, leaf) == 9.0f);
+
+    // Destroying the root turns its child into a root
+    coordinator.destroy_entity(root);
+
+    TEST_CHECK(update(coordinator, *hierarchy_system) == 3);
+    TEST_CHECK(world_x(coordinator, child) == 3.0f);
+    TEST_CHECK(world_x(coordinator, leaf) == 8.0f);
+
+    return EXIT_SUCCESS;
+}